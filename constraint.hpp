@@ -76,21 +76,21 @@ public:
 
     void set_coefficient( space::dimension_type type, int pos, int val )
     {
-        m_object = isl_constraint_set_coefficient_si
-                (m_object, (isl_dim_type) type, pos, val);
+        update(isl_constraint_set_coefficient_si
+                (m_object, (isl_dim_type) type, pos, val));
     }
     void set_coefficient( space::dimension_type type, int pos, const value & val )
     {
-        m_object = isl_constraint_set_coefficient_val
-                (m_object, (isl_dim_type) type, pos, val.copy());
+        update(isl_constraint_set_coefficient_val
+                (m_object, (isl_dim_type) type, pos, val.copy()));
     }
     void set_constant( int val )
     {
-        m_object = isl_constraint_set_constant_si(m_object, val);
+        update(isl_constraint_set_constant_si(m_object, val));
     }
     void set_constant( const value & val )
     {
-        m_object = isl_constraint_set_constant_val(m_object, val.copy());
+        update(isl_constraint_set_constant_val(m_object, val.copy()));
     }
     isl::expression expression() const
     {
@@ -102,7 +102,7 @@ public:
     }
     constraint & unwrap_space()
     {
-        m_object = isl_constraint_unwrap_local_space(m_object);
+        update(isl_constraint_unwrap_local_space(m_object));
         return *this;
     }
 };
@@ -19,9 +19,326 @@ along with this program; if not, write to the Free Software Foundation, Inc.,
 */
 
 #include "context.hpp"
+#include "result_cache.hpp"
+#include "intern.hpp"
+#include "space_cache.hpp"
+#include "parse_cache.hpp"
+
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 
 namespace isl {
 
-std::unordered_map<isl_ctx*, std::weak_ptr<context::data>> context::m_store;
+struct context::store_shard
+{
+    std::mutex mutex;
+    std::unordered_map<isl_ctx*, std::weak_ptr<data>> contexts;
+};
+
+context::store_shard & context::store_for( isl_ctx * ctx )
+{
+    static const int shard_count = 16;
+    static store_shard shards[shard_count];
+
+    // Skip the low bits, which are always zero due to alignment.
+    auto key = reinterpret_cast<std::uintptr_t>(ctx) >> 4;
+    return shards[key % shard_count];
+}
+
+context::context(): d( new data() )
+{
+    store_shard & store = store_for(d->ctx);
+    std::lock_guard<std::mutex> lock(store.mutex);
+    store.contexts[d->ctx] = d;
+}
+
+context::context( isl_ctx * ctx )
+{
+    if (ctx == nullptr)
+        return;
+
+    store_shard & store = store_for(ctx);
+    std::lock_guard<std::mutex> lock(store.mutex);
+
+    auto & entry = store.contexts[ctx];
+    d = entry.lock();
+    if (!d)
+    {
+        d = std::shared_ptr<data>( new data(ctx) );
+        entry = d;
+    }
+}
+
+context & context::for_this_thread()
+{
+    static thread_local context ctx;
+    return ctx;
+}
+
+struct context::data::id_table
+{
+    ~id_table()
+    {
+        for (auto & entry : ids)
+            isl_id_free(entry.second);
+    }
+
+    std::unordered_multimap<std::size_t, isl_id*> ids;
+};
+
+context::data::data(isl_ctx * ctx): ctx(ctx) {}
+
+context::data::data()
+{
+    ctx = isl_ctx_alloc();
+    //isl_options_set_on_error(ctx, ISL_ON_ERROR_CONTINUE);
+}
+
+context::data::~data()
+{
+    {
+        store_shard & store = store_for(ctx);
+        std::lock_guard<std::mutex> lock(store.mutex);
+        store.contexts.erase(ctx);
+    }
+
+    cache.reset();
+    interned.reset();
+    spaces.reset();
+    parsed.reset();
+    ids.reset();
+    isl_ctx_free(ctx);
+}
+
+void context::enable_result_cache( std::size_t max_bytes )
+{
+    if (d->cache)
+        d->cache->set_max_bytes(max_bytes);
+    else
+        d->cache.reset(new result_cache(max_bytes));
+}
+
+void context::disable_result_cache()
+{
+    d->cache.reset();
+}
+
+intern_table & context::interned_objects() const
+{
+    if (!d->interned)
+        d->interned.reset(new intern_table);
+    return *d->interned;
+}
+
+space_cache & context::spaces() const
+{
+    if (!d->spaces)
+        d->spaces.reset(new space_cache);
+    return *d->spaces;
+}
+
+parse_cache & context::parsed_texts() const
+{
+    if (!d->parsed)
+        d->parsed.reset(new parse_cache);
+    return *d->parsed;
+}
+
+isl_id * context::id( const string & name, void * user ) const
+{
+    if (!d->ids)
+        d->ids.reset(new data::id_table);
+
+    std::size_t hash = std::hash<string>()(name) * 31 + std::hash<void*>()(user);
+
+    auto range = d->ids->ids.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        isl_id * c_id = it->second;
+        const char * c_name = isl_id_get_name(c_id);
+        if (isl_id_get_user(c_id) == user && name == (c_name ? c_name : ""))
+            return isl_id_copy(c_id);
+    }
+
+    const char * c_name = name.empty() ? nullptr : name.c_str();
+    isl_id * c_id = isl_id_alloc(d->ctx, c_name, user);
+    if (c_id)
+        d->ids->ids.emplace(hash, isl_id_copy(c_id));
+    return c_id;
+}
+
+// Exported by isl, but declared only in its private headers.
+extern "C" int isl_ctx_next_operation( isl_ctx * ctx );
+
+namespace {
+
+thread_local context::budget_scope * innermost_budget_scope = nullptr;
+
+// The number of operations counted in ctx.
+//
+// isl has no way to read the count, so it is found by binary search:
+// with a limit set, asking for one more operation fails exactly when
+// the count has reached the limit, and adds one to the count otherwise.
+// Must be called with errors set to continue.
+unsigned long operations_done( isl_ctx * ctx )
+{
+    unsigned long saved_max = isl_ctx_get_max_operations(ctx);
+    unsigned long added = 0;
+
+    // Whether the count before probing was at least n, for n > 0.
+    auto at_least = [&]( unsigned long n )
+    {
+        isl_ctx_set_max_operations(ctx, n + added);
+        if (isl_ctx_next_operation(ctx) < 0)
+            return true;
+        ++added;
+        return false;
+    };
+
+    // The count is in [low, high).
+    unsigned long low = 0;
+    unsigned long high = 1;
+    while (high < (1ul << 62) && at_least(high))
+    {
+        low = high;
+        high *= 2;
+    }
+    while (high - low > 1)
+    {
+        unsigned long middle = low + (high - low) / 2;
+        if (at_least(middle))
+            low = middle;
+        else
+            high = middle;
+    }
+
+    isl_ctx_set_max_operations(ctx, saved_max);
+    isl_ctx_reset_error(ctx);
+    return low + added;
+}
+
+}
+
+struct context::budget_scope::watchdog
+{
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool done = false;
+    std::thread thread;
+};
+
+context::budget_scope::budget_scope( context & ctx, unsigned long max_operations ):
+    m_ctx(ctx)
+{
+    enter();
+
+    // The limit is on the count, which an enclosing scope may have
+    // advanced already, and may not exceed the limit of that scope.
+    unsigned long limit = m_start_operations + max_operations;
+    if (m_saved_max_operations && m_saved_max_operations < limit)
+        limit = m_saved_max_operations;
+    isl_ctx_set_max_operations(m_ctx.get(), limit);
+}
+
+context::budget_scope::budget_scope( context & ctx, std::chrono::milliseconds max_time ):
+    m_ctx(ctx)
+{
+    enter();
+
+    m_watchdog.reset(new watchdog);
+    watchdog * w = m_watchdog.get();
+    isl_ctx * c_ctx = m_ctx.get();
+    w->thread = std::thread([w, c_ctx, max_time]()
+    {
+        std::unique_lock<std::mutex> lock(w->mutex);
+        if (!w->wake.wait_for(lock, max_time, [w]{ return w->done; }))
+            isl_ctx_abort(c_ctx);
+    });
+}
+
+void context::budget_scope::enter()
+{
+    isl_ctx * c_ctx = m_ctx.get();
+
+    m_saved_max_operations = isl_ctx_get_max_operations(c_ctx);
+    m_saved_error_action = isl_options_get_on_error(c_ctx);
+
+    isl_options_set_on_error(c_ctx, ISL_ON_ERROR_CONTINUE);
+    isl_ctx_reset_error(c_ctx);
+
+    // Within an enclosing scope on the same context, the count goes on,
+    // so operations of this scope also count against the enclosing one.
+    bool nested = false;
+    for (auto scope = innermost_budget_scope; scope; scope = scope->m_outer)
+        nested = nested || scope->m_ctx.get() == c_ctx;
+
+    if (nested)
+    {
+        // After an abort, operations fail whatever the count.
+        m_start_operations = isl_ctx_aborted(c_ctx) ? 0 : operations_done(c_ctx);
+    }
+    else
+    {
+        isl_ctx_reset_operations(c_ctx);
+        m_start_operations = 0;
+    }
+
+    m_outer = innermost_budget_scope;
+    innermost_budget_scope = this;
+}
+
+context::budget_scope::~budget_scope()
+{
+    isl_ctx * c_ctx = m_ctx.get();
+
+    if (m_watchdog)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_watchdog->mutex);
+            m_watchdog->done = true;
+        }
+        m_watchdog->wake.notify_all();
+        m_watchdog->thread.join();
+        isl_ctx_resume(c_ctx);
+    }
+
+    isl_ctx_set_max_operations(c_ctx, m_saved_max_operations);
+    isl_options_set_on_error(c_ctx, m_saved_error_action);
+    isl_ctx_reset_error(c_ctx);
+
+    innermost_budget_scope = m_outer;
+}
+
+bool context::budget_scope::exceeded() const
+{
+    // After an abort, later failures may replace the last error,
+    // so check the abort flag itself.
+    isl_ctx * c_ctx = m_ctx.get();
+    isl_error e = isl_ctx_last_error(c_ctx);
+    return e == isl_error_quota || e == isl_error_abort || isl_ctx_aborted(c_ctx);
+}
+
+void context::budget_scope::check()
+{
+    for (auto scope = innermost_budget_scope; scope; scope = scope->m_outer)
+    {
+        if (scope->exceeded())
+            throw budget_exceeded();
+
+        isl_ctx * c_ctx = scope->m_ctx.get();
+        if (isl_ctx_last_error(c_ctx) != isl_error_none)
+        {
+            // Reset the error, so it is not thrown again once handled.
+            const char * msg = isl_ctx_last_error_msg(c_ctx);
+            error e(msg ? msg : "isl error.");
+            isl_ctx_reset_error(c_ctx);
+            throw e;
+        }
+    }
+}
 
 }
@@ -23,11 +23,15 @@ along with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include <isl/ctx.h>
 #include <isl/options.h>
+#include <isl/id.h>
 
 #include <memory>
 #include <unordered_map>
+#include <utility>
 #include <string>
 #include <exception>
+#include <chrono>
+#include <cstddef>
 
 namespace isl {
 
@@ -37,6 +41,10 @@ class matrix;
 class set;
 class map;
 class printer;
+class result_cache;
+class intern_table;
+class space_cache;
+class parse_cache;
 
 class context
 {
@@ -48,30 +56,31 @@ public:
         abort_on_error = ISL_ON_ERROR_ABORT
     };
 
-    context(): d( new data() )
-    {
-        m_store.emplace(d.get()->ctx, d);
-    }
+    context();
     context( const context & other ):
         d(other.d)
     {}
+    context( context && other ):
+        d(std::move(other.d))
+    {}
 
-    context( isl_ctx * ctx )
+    context & operator=( const context & other )
     {
-        if (ctx == nullptr)
-            return;
-
-        auto iter = m_store.find(ctx);
-        if (iter != m_store.end())
-        {
-            d = iter->second.lock();
-        }
-        else
-        {
-            d = std::shared_ptr<data>( new data(ctx) );
-            m_store.emplace(ctx, d);
-        }
+        d = other.d;
+        return *this;
     }
+    context & operator=( context && other )
+    {
+        d = std::move(other.d);
+        return *this;
+    }
+
+    context( isl_ctx * ctx );
+
+    // A context owned by the calling thread, created on first use.
+    // Work on independent contexts may run on different threads
+    // concurrently.
+    static context & for_this_thread();
 
     void set_error_action( int action )
     {
@@ -83,34 +92,75 @@ public:
         return isl_options_get_on_error(get());
     }
 
+    // Limits the number of operations isl may perform.
+    // Zero means no limit.
+    void set_max_operations( unsigned long count )
+    {
+        isl_ctx_set_max_operations(get(), count);
+    }
+
+    unsigned long max_operations() const
+    {
+        return isl_ctx_get_max_operations(get());
+    }
+
+    void reset_operations()
+    {
+        isl_ctx_reset_operations(get());
+    }
+
+    class budget_scope;
+
+    // Remembers results of expensive queries on objects in this context,
+    // holding on to at most about max_bytes of isl objects.
+    void enable_result_cache( std::size_t max_bytes = 64 << 20 );
+    void disable_result_cache();
+
+    // The result cache, or null if not enabled.
+    result_cache * cache() const { return d->cache.get(); }
+
+    // The table of shared objects, created on first use.
+    intern_table & interned_objects() const;
+
+    // Spaces built from tuples, created on first use.
+    space_cache & spaces() const;
+
+    // Objects parsed from text, created on first use.
+    parse_cache & parsed_texts() const;
+
+    // Returns a new reference to the id with the given name and user
+    // pointer. Ids are kept in this context, so naming the same tuples
+    // over and over does not go through isl_id_alloc.
+    isl_id * id( const string & name, void * user ) const;
+
     isl_ctx *get() const { return d->ctx; }
 
 private:
 
     struct data
     {
-        data(isl_ctx * ctx): ctx(ctx) {}
-
-        data()
-        {
-            ctx = isl_ctx_alloc();
-            //isl_options_set_on_error(ctx, ISL_ON_ERROR_CONTINUE);
-        }
-
-        ~data()
-        {
-            context::m_store.erase(ctx);
-            isl_ctx_free(ctx);
-        }
+        data(isl_ctx * ctx);
+        data();
+        ~data();
 
         isl_ctx *ctx;
+        std::unique_ptr<result_cache> cache;
+        std::unique_ptr<intern_table> interned;
+        std::unique_ptr<space_cache> spaces;
+        std::unique_ptr<parse_cache> parsed;
+
+        struct id_table;
+        std::unique_ptr<id_table> ids;
     };
 
     friend class data;
 
     std::shared_ptr<data> d;
 
-    static std::unordered_map<isl_ctx*, std::weak_ptr<data>> m_store;
+    // The store of live contexts is split into shards,
+    // each guarded by its own mutex.
+    struct store_shard;
+    static store_shard & store_for( isl_ctx * ctx );
 };
 
 class error : public std::exception
@@ -118,7 +168,7 @@ class error : public std::exception
 public:
     error() {}
     error( const string & what ): m_what(what) {}
-    virtual const char *what()
+    virtual const char *what() const noexcept
     {
         return m_what.c_str();
     }
@@ -126,6 +176,62 @@ private:
     string m_what;
 };
 
+class budget_exceeded : public error
+{
+public:
+    budget_exceeded(): error("Operation budget exceeded.") {}
+};
+
+// Bounds the work isl may do in a context while the scope is alive,
+// either by a number of isl operations or by wall-clock time.
+// Once the budget is exceeded, isl operations in the context fail
+// and the wrappers throw budget_exceeded.
+//
+// While a scope is active, other isl errors in its context are
+// thrown as isl::error instead of aborting. Scopes must be nested
+// on each thread. Operations in a nested scope also count against
+// the enclosing scopes, and a nested scope gets at most the budget
+// they have left.
+
+class context::budget_scope
+{
+public:
+    budget_scope( context & ctx, unsigned long max_operations );
+    budget_scope( context & ctx, std::chrono::milliseconds max_time );
+    ~budget_scope();
+
+    budget_scope( const budget_scope & ) = delete;
+    budget_scope & operator=( const budget_scope & ) = delete;
+
+    bool exceeded() const;
+
+    // Throws if an isl operation failed in the context of
+    // any scope active on this thread.
+    static void check();
+
+private:
+    void enter();
+
+    struct watchdog;
+
+    context m_ctx;
+    unsigned long m_saved_max_operations;
+    unsigned long m_start_operations;
+    int m_saved_error_action;
+    budget_scope * m_outer;
+    std::unique_ptr<watchdog> m_watchdog;
+};
+
+// Passes on the result of an isl query, throwing if it failed
+// inside a budget_scope.
+inline
+isl_bool checked( isl_bool result )
+{
+    if (result == isl_bool_error)
+        context::budget_scope::check();
+    return result;
+}
+
 }
 
 #endif // ISL_CPP_CONTEXT_INCLUDED
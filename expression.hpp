@@ -271,12 +271,12 @@ public:
 
     void insert_dims(isl::space::dimension_type type, unsigned i, unsigned n)
     {
-        m_object = isl_multi_aff_insert_dims(m_object, (isl_dim_type)type, i, n);
+        update(isl_multi_aff_insert_dims(m_object, (isl_dim_type)type, i, n));
     }
 
     void drop_dims(isl::space::dimension_type type, unsigned i, unsigned n)
     {
-        m_object = isl_multi_aff_drop_dims(m_object, (isl_dim_type)type, i, n);
+        update(isl_multi_aff_drop_dims(m_object, (isl_dim_type)type, i, n));
     }
 
     expression at(int i) const
@@ -286,7 +286,7 @@ public:
 
     void set(int i, const expression & e)
     {
-        m_object = isl_multi_aff_set_aff(m_object, i, e.copy());
+        update(isl_multi_aff_set_aff(m_object, i, e.copy()));
     }
 };
 
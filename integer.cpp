@@ -0,0 +1,247 @@
+/*
+isl-cpp: C++ bindings to the ISL (Integer Set Library)
+
+Copyright (C) 2014  Jakob Leben <jakob.leben@gmail.com>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "integer.hpp"
+
+#include <climits>
+#include <cstdlib>
+
+namespace isl {
+
+namespace {
+
+const size_t limb_size = sizeof(uint64_t);
+
+// Magnitude of x, without overflow for the most negative value.
+uint64_t magnitude( int64_t x )
+{
+    return x < 0 ? uint64_t(-(x + 1)) + 1 : uint64_t(x);
+}
+
+void check_divisor( const integer & b )
+{
+    if (b.sign() == 0)
+        throw error("Division by zero.");
+}
+
+}
+
+namespace detail {
+
+isl_val * int64_val( isl_ctx * ctx, int64_t x )
+{
+    if (x >= LONG_MIN && x <= LONG_MAX)
+        return isl_val_int_from_si(ctx, (long) x);
+
+    uint64_t m = magnitude(x);
+    isl_val * v = isl_val_int_from_chunks(ctx, 1, limb_size, &m);
+    return x < 0 ? isl_val_neg(v) : v;
+}
+
+bool take_int64( isl_val * v, int64_t & out )
+{
+    out = 0;
+    if (!v)
+    {
+        context::budget_scope::check();
+        return false;
+    }
+    if (isl_val_is_int(v) != isl_bool_true)
+    {
+        isl_val_free(v);
+        return false;
+    }
+
+    // Most values fit in 32 bits, and counting 32-bit chunks
+    // is cheaper than exporting them.
+    if (isl_val_n_abs_num_chunks(v, sizeof(uint32_t)) <= 1)
+    {
+        out = isl_val_get_num_si(v);
+        isl_val_free(v);
+        return true;
+    }
+
+    bool fits = true;
+    if (isl_val_n_abs_num_chunks(v, limb_size) <= 1)
+    {
+        uint64_t mag = 0;
+        isl_val_get_abs_num_chunks(v, limb_size, &mag);
+        bool negative = isl_val_is_neg(v) == isl_bool_true;
+        if (mag <= uint64_t(INT64_MAX))
+            out = negative ? -int64_t(mag) : int64_t(mag);
+        else if (negative && mag == uint64_t(INT64_MAX) + 1)
+            out = INT64_MIN;
+        else
+            fits = false;
+    }
+    else
+    {
+        fits = false;
+    }
+
+    isl_val_free(v);
+    return fits;
+}
+
+}
+
+integer::integer( const value & v ):
+    m_ctx(isl_val_get_ctx(v.get())), m_big(nullptr), m_small(0)
+{
+    if (isl_val_is_int(v.get()) != isl_bool_true)
+        throw error("Value is not an integer.");
+    *this = from_val(m_ctx, v.copy());
+}
+
+integer integer::from_val( isl_ctx * ctx, isl_val * v )
+{
+    if (!v)
+    {
+        context::budget_scope::check();
+        throw error("Integer operation failed.");
+    }
+
+    integer result(ctx, int64_t(0));
+    if (!detail::take_int64(isl_val_copy(v), result.m_small))
+        result.m_big = v;
+    else
+        isl_val_free(v);
+    return result;
+}
+
+std::string integer::to_string() const
+{
+    if (!m_big)
+        return std::to_string(m_small);
+
+    char * text = isl_val_to_str(m_big);
+    std::string result(text);
+    free(text);
+    return result;
+}
+
+int integer::compare_slow( const integer & other ) const
+{
+    if (!other.m_big)
+        return compare(other.m_small);
+    if (!m_big)
+        return -other.compare(m_small);
+
+    isl_val * d = isl_val_sub(isl_val_copy(m_big), isl_val_copy(other.m_big));
+    int result = isl_val_sgn(d);
+    isl_val_free(d);
+    return result;
+}
+
+integer & integer::operator/=( const integer & other )
+{
+    check_divisor(other);
+
+    if (!m_big && !other.m_big && !(m_small == INT64_MIN && other.m_small == -1))
+    {
+        m_small /= other.m_small;
+        return *this;
+    }
+
+    isl_val * q = isl_val_div(big_copy(), other.big_copy());
+    q = isl_val_is_neg(q) == isl_bool_true ? isl_val_ceil(q) : isl_val_floor(q);
+    *this = from_val(m_ctx, q);
+    return *this;
+}
+
+integer floor_div( const integer & a, const integer & b )
+{
+    check_divisor(b);
+
+    if (!a.m_big && !b.m_big && !(a.m_small == INT64_MIN && b.m_small == -1))
+    {
+        int64_t q = a.m_small / b.m_small;
+        if (a.m_small % b.m_small != 0 && ((a.m_small < 0) != (b.m_small < 0)))
+            --q;
+        return integer(a.m_ctx, q);
+    }
+
+    return integer::from_val(a.m_ctx, isl_val_floor(isl_val_div(a.big_copy(), b.big_copy())));
+}
+
+integer ceil_div( const integer & a, const integer & b )
+{
+    check_divisor(b);
+
+    if (!a.m_big && !b.m_big && !(a.m_small == INT64_MIN && b.m_small == -1))
+    {
+        int64_t q = a.m_small / b.m_small;
+        if (a.m_small % b.m_small != 0 && ((a.m_small < 0) == (b.m_small < 0)))
+            ++q;
+        return integer(a.m_ctx, q);
+    }
+
+    return integer::from_val(a.m_ctx, isl_val_ceil(isl_val_div(a.big_copy(), b.big_copy())));
+}
+
+integer mod( const integer & a, const integer & b )
+{
+    check_divisor(b);
+
+    if (!a.m_big && !b.m_big)
+    {
+        if (b.m_small == -1)
+            return integer(a.m_ctx, int64_t(0));
+        int64_t r = a.m_small % b.m_small;
+        if (r != 0 && ((r < 0) != (b.m_small < 0)))
+            r += b.m_small;
+        return integer(a.m_ctx, r);
+    }
+
+    // a - b * floor(a / b)
+    return a - b * floor_div(a, b);
+}
+
+integer gcd( const integer & a, const integer & b )
+{
+    if (!a.m_big && !b.m_big)
+    {
+        uint64_t x = magnitude(a.m_small);
+        uint64_t y = magnitude(b.m_small);
+        while (y != 0)
+        {
+            uint64_t r = x % y;
+            x = y;
+            y = r;
+        }
+        // Only gcd(INT64_MIN, INT64_MIN) and gcd(INT64_MIN, 0)
+        // do not fit.
+        if (x <= uint64_t(INT64_MAX))
+            return integer(a.m_ctx, int64_t(x));
+    }
+
+    return integer::from_val(a.m_ctx, isl_val_abs(isl_val_gcd(a.big_copy(), b.big_copy())));
+}
+
+integer lcm( const integer & a, const integer & b )
+{
+    if (a.sign() == 0 || b.sign() == 0)
+        return integer(a.m_ctx, int64_t(0));
+
+    integer result = a / gcd(a, b) * b;
+    return result.sign() < 0 ? -result : result;
+}
+
+}
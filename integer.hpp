@@ -0,0 +1,268 @@
+/*
+isl-cpp: C++ bindings to the ISL (Integer Set Library)
+
+Copyright (C) 2014  Jakob Leben <jakob.leben@gmail.com>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef ISL_CPP_INTEGER_INCLUDED
+#define ISL_CPP_INTEGER_INCLUDED
+
+#include "context.hpp"
+#include "value.hpp"
+#include "printer.hpp"
+
+#include <isl/val.h>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace isl {
+
+namespace detail {
+
+// Conversions between int64_t and integer isl values.
+isl_val * int64_val( isl_ctx * ctx, int64_t x );
+// Frees v. Stores zero and returns false if v is null,
+// is not an integer or does not fit.
+bool take_int64( isl_val * v, int64_t & out );
+
+}
+
+// An exact integer that is stored inline while it fits in 64 bits,
+// and as an isl_val only when it does not.
+//
+// Arithmetic on small integers allocates nothing. An operation that
+// overflows is redone on isl values, and a result that fits in 64 bits
+// again is stored inline again.
+//
+// Like compact handles, an integer refers to its context without
+// keeping it alive, so it must not outlive the context.
+
+class integer
+{
+public:
+    integer( const context & ctx, int64_t v ):
+        m_ctx(ctx.get()), m_big(nullptr), m_small(v)
+    {}
+
+    // Throws if v is not an integer.
+    explicit integer( const value & v );
+
+    integer( const integer & other ):
+        m_ctx(other.m_ctx),
+        m_big(other.m_big ? isl_val_copy(other.m_big) : nullptr),
+        m_small(other.m_small)
+    {}
+
+    integer( integer && other ):
+        m_ctx(other.m_ctx), m_big(other.m_big), m_small(other.m_small)
+    {
+        other.m_big = nullptr;
+    }
+
+    ~integer()
+    {
+        if (m_big)
+            isl_val_free(m_big);
+    }
+
+    integer & operator=( const integer & other )
+    {
+        if (this != &other)
+        {
+            if (m_big)
+                isl_val_free(m_big);
+            m_ctx = other.m_ctx;
+            m_big = other.m_big ? isl_val_copy(other.m_big) : nullptr;
+            m_small = other.m_small;
+        }
+        return *this;
+    }
+
+    integer & operator=( integer && other )
+    {
+        std::swap(m_ctx, other.m_ctx);
+        std::swap(m_big, other.m_big);
+        std::swap(m_small, other.m_small);
+        return *this;
+    }
+
+    integer & operator=( int64_t v )
+    {
+        if (m_big)
+            isl_val_free(m_big);
+        m_big = nullptr;
+        m_small = v;
+        return *this;
+    }
+
+    isl_ctx * c_context() const { return m_ctx; }
+
+    bool fits_int64() const { return !m_big; }
+
+    // Throws if the integer does not fit in 64 bits.
+    int64_t to_int64() const
+    {
+        if (m_big)
+            throw error("Integer does not fit in 64 bits.");
+        return m_small;
+    }
+
+    value to_value() const
+    {
+        return value(m_big ? isl_val_copy(m_big) : detail::int64_val(m_ctx, m_small));
+    }
+
+    std::string to_string() const;
+
+    // -1, 0 or 1 as this is less than,
+    // equal to or greater than other.
+    int compare( const integer & other ) const
+    {
+        if (!m_big && !other.m_big)
+            return (m_small > other.m_small) - (m_small < other.m_small);
+        return compare_slow(other);
+    }
+
+    int compare( int64_t other ) const
+    {
+        if (!m_big)
+            return (m_small > other) - (m_small < other);
+        int c = isl_val_cmp_si(m_big, other);
+        return (c > 0) - (c < 0);
+    }
+
+    int sign() const
+    {
+        if (!m_big)
+            return (m_small > 0) - (m_small < 0);
+        return isl_val_sgn(m_big);
+    }
+
+    integer operator-() const
+    {
+        if (!m_big && m_small != INT64_MIN)
+            return integer(m_ctx, -m_small);
+        return from_val(m_ctx, isl_val_neg(big_copy()));
+    }
+
+    integer & operator+=( const integer & other )
+    {
+        int64_t result;
+        if (!m_big && !other.m_big && !__builtin_add_overflow(m_small, other.m_small, &result))
+            m_small = result;
+        else
+            *this = from_val(m_ctx, isl_val_add(big_copy(), other.big_copy()));
+        return *this;
+    }
+
+    integer & operator-=( const integer & other )
+    {
+        int64_t result;
+        if (!m_big && !other.m_big && !__builtin_sub_overflow(m_small, other.m_small, &result))
+            m_small = result;
+        else
+            *this = from_val(m_ctx, isl_val_sub(big_copy(), other.big_copy()));
+        return *this;
+    }
+
+    integer & operator*=( const integer & other )
+    {
+        int64_t result;
+        if (!m_big && !other.m_big && !__builtin_mul_overflow(m_small, other.m_small, &result))
+            m_small = result;
+        else
+            *this = from_val(m_ctx, isl_val_mul(big_copy(), other.big_copy()));
+        return *this;
+    }
+
+    // Rounds toward zero, like the built-in division.
+    integer & operator/=( const integer & other );
+
+    integer & operator+=( int64_t v ) { return *this += integer(m_ctx, v); }
+    integer & operator-=( int64_t v ) { return *this -= integer(m_ctx, v); }
+    integer & operator*=( int64_t v ) { return *this *= integer(m_ctx, v); }
+    integer & operator/=( int64_t v ) { return *this /= integer(m_ctx, v); }
+
+    friend integer floor_div( const integer & a, const integer & b );
+    friend integer ceil_div( const integer & a, const integer & b );
+    friend integer mod( const integer & a, const integer & b );
+    friend integer gcd( const integer & a, const integer & b );
+    friend integer lcm( const integer & a, const integer & b );
+
+private:
+    integer( isl_ctx * ctx, int64_t v ): m_ctx(ctx), m_big(nullptr), m_small(v) {}
+
+    // Takes v, and stores it inline if it fits.
+    static integer from_val( isl_ctx * ctx, isl_val * v );
+
+    // This integer as a new isl_val, regardless of representation.
+    isl_val * big_copy() const
+    {
+        return m_big ? isl_val_copy(m_big) : detail::int64_val(m_ctx, m_small);
+    }
+
+    int compare_slow( const integer & other ) const;
+
+    isl_ctx * m_ctx;
+    isl_val * m_big;
+    int64_t m_small;
+};
+
+inline integer operator+( integer a, const integer & b ) { return a += b; }
+inline integer operator-( integer a, const integer & b ) { return a -= b; }
+inline integer operator*( integer a, const integer & b ) { return a *= b; }
+inline integer operator/( integer a, const integer & b ) { return a /= b; }
+
+inline integer operator+( integer a, int64_t b ) { return a += b; }
+inline integer operator-( integer a, int64_t b ) { return a -= b; }
+inline integer operator*( integer a, int64_t b ) { return a *= b; }
+inline integer operator/( integer a, int64_t b ) { return a /= b; }
+
+inline bool operator==( const integer & a, const integer & b ) { return a.compare(b) == 0; }
+inline bool operator!=( const integer & a, const integer & b ) { return a.compare(b) != 0; }
+inline bool operator<( const integer & a, const integer & b ) { return a.compare(b) < 0; }
+inline bool operator<=( const integer & a, const integer & b ) { return a.compare(b) <= 0; }
+inline bool operator>( const integer & a, const integer & b ) { return a.compare(b) > 0; }
+inline bool operator>=( const integer & a, const integer & b ) { return a.compare(b) >= 0; }
+
+inline bool operator==( const integer & a, int64_t b ) { return a.compare(b) == 0; }
+inline bool operator!=( const integer & a, int64_t b ) { return a.compare(b) != 0; }
+inline bool operator<( const integer & a, int64_t b ) { return a.compare(b) < 0; }
+inline bool operator<=( const integer & a, int64_t b ) { return a.compare(b) <= 0; }
+inline bool operator>( const integer & a, int64_t b ) { return a.compare(b) > 0; }
+inline bool operator>=( const integer & a, int64_t b ) { return a.compare(b) >= 0; }
+
+// Rounded down and up.
+integer floor_div( const integer & a, const integer & b );
+integer ceil_div( const integer & a, const integer & b );
+// The remainder of floor_div, with the sign of b.
+integer mod( const integer & a, const integer & b );
+// Non-negative.
+integer gcd( const integer & a, const integer & b );
+integer lcm( const integer & a, const integer & b );
+
+template<> inline
+void printer::print<integer>( const integer & i )
+{
+    m_printer = isl_printer_print_str(m_printer, i.to_string().c_str());
+}
+
+}
+
+#endif // ISL_CPP_INTEGER_INCLUDED
@@ -0,0 +1,153 @@
+/*
+isl-cpp: C++ bindings to the ISL (Integer Set Library)
+
+Copyright (C) 2014  Jakob Leben <jakob.leben@gmail.com>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "intern.hpp"
+
+#include <unordered_map>
+
+namespace isl {
+
+namespace {
+
+template <typename T>
+struct intern_behavior
+{};
+
+template <>
+struct intern_behavior<isl_basic_set>
+{
+    static uint32_t hash( isl_basic_set * s ) { return isl_basic_set_get_hash(s); }
+    static isl_bool equal( isl_basic_set * a, isl_basic_set * b )
+    { return isl_basic_set_plain_is_equal(a, b); }
+};
+
+template <>
+struct intern_behavior<isl_set>
+{
+    static uint32_t hash( isl_set * s ) { return isl_set_get_hash(s); }
+    static isl_bool equal( isl_set * a, isl_set * b )
+    { return isl_set_plain_is_equal(a, b); }
+};
+
+template <>
+struct intern_behavior<isl_basic_map>
+{
+    static uint32_t hash( isl_basic_map * m ) { return isl_basic_map_get_hash(m); }
+    static isl_bool equal( isl_basic_map * a, isl_basic_map * b )
+    { return isl_basic_map_plain_is_equal(a, b); }
+};
+
+template <>
+struct intern_behavior<isl_map>
+{
+    static uint32_t hash( isl_map * m ) { return isl_map_get_hash(m); }
+    static isl_bool equal( isl_map * a, isl_map * b )
+    { return isl_map_plain_is_equal(a, b); }
+};
+
+template <typename T>
+class table
+{
+public:
+    ~table() { clear(); }
+
+    // Returns a new reference to the interned equal of obj.
+    T * intern( T * obj )
+    {
+        if (!obj)
+            return nullptr;
+
+        uint32_t hash = intern_behavior<T>::hash(obj);
+
+        auto range = m_objects.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            T * candidate = it->second;
+            if (candidate == obj ||
+                    checked(intern_behavior<T>::equal(candidate, obj)) == isl_bool_true)
+                return object_behavior<T>::copy(candidate);
+        }
+
+        m_objects.emplace(hash, object_behavior<T>::copy(obj));
+        return object_behavior<T>::copy(obj);
+    }
+
+    std::size_t size() const { return m_objects.size(); }
+
+    void clear()
+    {
+        for (auto & entry : m_objects)
+            object_behavior<T>::destroy(entry.second);
+        m_objects.clear();
+    }
+
+private:
+    std::unordered_multimap<uint32_t, T*> m_objects;
+};
+
+}
+
+struct intern_table::tables
+{
+    table<isl_basic_set> basic_sets;
+    table<isl_set> sets;
+    table<isl_basic_map> basic_maps;
+    table<isl_map> maps;
+};
+
+intern_table::intern_table(): d(new tables) {}
+
+intern_table::~intern_table() {}
+
+basic_set intern_table::intern( const basic_set & s )
+{
+    return d->basic_sets.intern(s.get());
+}
+
+set intern_table::intern( const set & s )
+{
+    return d->sets.intern(s.get());
+}
+
+basic_map intern_table::intern( const basic_map & m )
+{
+    return d->basic_maps.intern(m.get());
+}
+
+map intern_table::intern( const map & m )
+{
+    return d->maps.intern(m.get());
+}
+
+std::size_t intern_table::size() const
+{
+    return d->basic_sets.size() + d->sets.size() +
+            d->basic_maps.size() + d->maps.size();
+}
+
+void intern_table::clear()
+{
+    d->basic_sets.clear();
+    d->sets.clear();
+    d->basic_maps.clear();
+    d->maps.clear();
+}
+
+}
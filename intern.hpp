@@ -0,0 +1,72 @@
+/*
+isl-cpp: C++ bindings to the ISL (Integer Set Library)
+
+Copyright (C) 2014  Jakob Leben <jakob.leben@gmail.com>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef ISL_CPP_INTERN_INCLUDED
+#define ISL_CPP_INTERN_INCLUDED
+
+#include "context.hpp"
+#include "set.hpp"
+#include "map.hpp"
+
+#include <cstddef>
+#include <memory>
+
+namespace isl {
+
+// Shares one isl object among all structurally equal objects
+// interned in a context. Objects are matched by their isl hash
+// and plain equality, which both work on isl's normal form,
+// so objects built separately in different ways still match.
+//
+// Interned objects that are equal have the same get() pointer.
+// The table keeps its objects alive until it is cleared.
+
+class intern_table
+{
+public:
+    intern_table();
+    ~intern_table();
+
+    intern_table( const intern_table & ) = delete;
+    intern_table & operator=( const intern_table & ) = delete;
+
+    basic_set intern( const basic_set & );
+    set intern( const set & );
+    basic_map intern( const basic_map & );
+    map intern( const map & );
+
+    std::size_t size() const;
+    void clear();
+
+private:
+    struct tables;
+    std::unique_ptr<tables> d;
+};
+
+// Returns the shared instance equal to obj.
+template <typename T> inline
+T intern( const T & obj )
+{
+    return obj.ctx().interned_objects().intern(obj);
+}
+
+}
+
+#endif // ISL_CPP_INTERN_INCLUDED
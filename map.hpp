@@ -29,6 +29,7 @@ along with this program; if not, write to the Free Software Foundation, Inc.,
 #include "constraint.hpp"
 #include "matrix.hpp"
 #include "printer.hpp"
+#include "result_cache.hpp"
 
 #include <isl/map.h>
 #include <iostream>
@@ -136,41 +137,57 @@ public:
     {
         return isl_basic_map_get_local_space(get());
     }
-    basic_set range() const
+    basic_set range() const &
     {
         return isl_basic_map_range(copy());
     }
-    basic_set domain() const
+    basic_set range() &&
+    {
+        return isl_basic_map_range(release());
+    }
+    basic_set domain() const &
     {
         return isl_basic_map_domain(copy());
     }
+    basic_set domain() &&
+    {
+        return isl_basic_map_domain(release());
+    }
     bool is_empty() const
     {
-        return isl_basic_map_is_empty(get());
+        return checked(isl_basic_map_is_empty(get()));
     }
     bool is_single_valued() const
     {
-        return isl_basic_map_is_single_valued(get());
+        return checked(isl_basic_map_is_single_valued(get()));
     }
     bool is_subset_of(const basic_map & other) const
     {
-        return isl_basic_map_is_subset(get(), other.get());
+        return checked(isl_basic_map_is_subset(get(), other.get()));
     }
     bool is_strict_subset_of(const basic_map & other) const
     {
-        return isl_basic_map_is_strict_subset(get(), other.get());
+        return checked(isl_basic_map_is_strict_subset(get(), other.get()));
     }
-    basic_map inverse() const
+    basic_map inverse() const &
     {
         return basic_map( isl_basic_map_reverse(copy()) );
     }
-    basic_set wrapped() const
+    basic_map inverse() &&
+    {
+        return basic_map( isl_basic_map_reverse(release()) );
+    }
+    basic_set wrapped() const &
     {
         return isl_basic_map_wrap(copy());
     }
+    basic_set wrapped() &&
+    {
+        return isl_basic_map_wrap(release());
+    }
     void project_out_dimensions( space::dimension_type type, unsigned i, unsigned n=1 )
     {
-        m_object = isl_basic_map_project_out(m_object, (isl_dim_type)type, i, n);
+        update(isl_basic_map_project_out(m_object, (isl_dim_type)type, i, n));
     }
     void add_constraint( const constraint & c )
     {
@@ -178,12 +195,12 @@ public:
         if (c.local_space().is_wrapping())
             isl_c = isl_constraint_unwrap_local_space(isl_c);
 
-        m_object = isl_basic_map_add_constraint(m_object, isl_c);
+        update(isl_basic_map_add_constraint(m_object, isl_c));
     }
     void drop_constraints_with( space::dimension_type t, unsigned i, unsigned n=1)
     {
-        m_object = isl_basic_map_drop_constraints_involving_dims
-                (m_object, (isl_dim_type) t, i, n);
+        update(isl_basic_map_drop_constraints_involving_dims
+                (m_object, (isl_dim_type) t, i, n));
     }
     matrix equalities_matrix() const
     {
@@ -206,22 +223,30 @@ public:
                  isl_dim_cst);
     }
 
-    basic_map in_domain( const basic_set & domain ) const
+    basic_map in_domain( const basic_set & domain ) const &
     {
         return isl_basic_map_intersect_domain(copy(), domain.copy());
     }
-    basic_map in_range( const basic_set & range ) const
+    basic_map in_domain( const basic_set & domain ) &&
+    {
+        return isl_basic_map_intersect_domain(release(), domain.copy());
+    }
+    basic_map in_range( const basic_set & range ) const &
     {
         return isl_basic_map_intersect_range(copy(), range.copy());
     }
+    basic_map in_range( const basic_set & range ) &&
+    {
+        return isl_basic_map_intersect_range(release(), range.copy());
+    }
     basic_map & limit_above(isl::space::dimension_type dim, unsigned pos, int value)
     {
-        m_object = isl_basic_map_upper_bound_si(m_object, (isl_dim_type)dim, pos, value);
+        update(isl_basic_map_upper_bound_si(m_object, (isl_dim_type)dim, pos, value));
         return *this;
     }
     basic_map & limit_below(isl::space::dimension_type dim, unsigned pos, int value)
     {
-        m_object = isl_basic_map_lower_bound_si(m_object, (isl_dim_type)dim, pos, value);
+        update(isl_basic_map_lower_bound_si(m_object, (isl_dim_type)dim, pos, value));
         return *this;
     }
     basic_map cross( const basic_map & rhs ) const
@@ -232,10 +257,14 @@ public:
     {
         return isl_basic_map_equate(copy(), isl_dim_in, in_dim, isl_dim_out, out_dim);
     }
-    basic_set deltas() const
+    basic_set deltas() const &
     {
         return isl_basic_map_deltas(copy());
     }
+    basic_set deltas() &&
+    {
+        return isl_basic_map_deltas(release());
+    }
 };
 
 class map : public object<isl_map>
@@ -285,58 +314,103 @@ public:
         return space( isl_space_range_map(isl_map_get_space(get())) );
     }
 #endif
-    set range() const
+    set range() const &
     {
         return isl_map_range(copy());
     }
-    set domain() const
+    set range() &&
+    {
+        return isl_map_range(release());
+    }
+    set domain() const &
     {
         return isl_map_domain(copy());
     }
+    set domain() &&
+    {
+        return isl_map_domain(release());
+    }
     bool is_single_valued() const
     {
-        return isl_map_is_single_valued(get());
+        return checked(isl_map_is_single_valued(get()));
     }
     bool is_empty() const
     {
-        return isl_map_is_empty(get());
+        return cached_answer(*this, result_cache::is_empty_query, {},
+                             [&]{ return isl_map_is_empty(get()); });
+    }
+    // A hash of the normalized map, equal for plainly equal maps.
+    // Hash containers should compare keys with plain_equal<map>.
+    std::size_t hash() const
+    {
+        return isl_map_get_hash(get());
     }
     bool is_subset_of(const map & other) const
     {
-        return isl_map_is_subset(get(), other.get());
+        return cached_answer(*this, result_cache::is_subset_query, other.get(),
+                             [&]{ return isl_map_is_subset(get(), other.get()); });
     }
     bool is_strict_subset_of(const map & other) const
     {
-        return isl_map_is_strict_subset(get(), other.get());
+        return checked(isl_map_is_strict_subset(get(), other.get()));
     }
-    map inverse() const
+    map inverse() const &
     {
         return map( isl_map_reverse(copy()) );
     }
-    set wrapped() const
+    map inverse() &&
+    {
+        return map( isl_map_reverse(release()) );
+    }
+    set wrapped() const &
     {
         return isl_map_wrap(copy());
     }
-    map lex_minimum() const
+    set wrapped() &&
     {
-        return isl_map_lexmin(copy());
+        return isl_map_wrap(release());
     }
-    map lex_maximum() const
+    map lex_minimum() const &
     {
-        return isl_map_lexmax(copy());
+        return cached_result<isl_map>(*this, result_cache::lex_minimum_query, {},
+                                      [&]{ return isl_map_lexmin(copy()); });
+    }
+    map lex_minimum() &&
+    {
+        return cached_result<isl_map>(*this, result_cache::lex_minimum_query, {},
+                                      [&]{ return isl_map_lexmin(release()); });
+    }
+    map lex_maximum() const &
+    {
+        return cached_result<isl_map>(*this, result_cache::lex_maximum_query, {},
+                                      [&]{ return isl_map_lexmax(copy()); });
+    }
+    map lex_maximum() &&
+    {
+        return cached_result<isl_map>(*this, result_cache::lex_maximum_query, {},
+                                      [&]{ return isl_map_lexmax(release()); });
     }
     void coalesce()
     {
-        m_object = isl_map_coalesce(m_object);
+        *this = cached_in_place_result<isl_map>(*this, result_cache::coalesce_query,
+                                                [&]{ return isl_map_coalesce(release()); });
     }
-    map in_domain( const set & domain ) const
+    map in_domain( const set & domain ) const &
     {
         return isl_map_intersect_domain(copy(), domain.copy());
     }
-    map in_range( const set & range ) const
+    map in_domain( const set & domain ) &&
+    {
+        return isl_map_intersect_domain(release(), domain.copy());
+    }
+    map in_range( const set & range ) const &
     {
         return isl_map_intersect_range(copy(), range.copy());
     }
+    map in_range( const set & range ) &&
+    {
+        return isl_map_intersect_range(release(), range.copy());
+    }
     set operator() ( const set & arg ) const
     {
         return isl_set_apply( arg.copy(), copy() );
@@ -347,47 +421,59 @@ public:
     }
     map & subtract (const map & rhs)
     {
-        m_object = isl_map_subtract(m_object, rhs.copy());
+        update(isl_map_subtract(m_object, rhs.copy()));
         return *this;
     }
     map & limit_above(isl::space::dimension_type dim, unsigned pos, int value)
     {
-        m_object = isl_map_upper_bound_si(m_object, (isl_dim_type)dim, pos, value);
+        update(isl_map_upper_bound_si(m_object, (isl_dim_type)dim, pos, value));
         return *this;
     }
     map & limit_below(isl::space::dimension_type dim, unsigned pos, int value)
     {
-        m_object = isl_map_lower_bound_si(m_object, (isl_dim_type)dim, pos, value);
+        update(isl_map_lower_bound_si(m_object, (isl_dim_type)dim, pos, value));
         return *this;
     }
     map cross( const map & rhs ) const
     {
         return isl_map_product(copy(), rhs.copy());
     }
-    basic_map convex_hull() const
+    basic_map convex_hull() const &
     {
         return isl_map_convex_hull(copy());
     }
-    basic_map simple_hull() const
+    basic_map convex_hull() &&
+    {
+        return isl_map_convex_hull(release());
+    }
+    basic_map simple_hull() const &
     {
         return isl_map_simple_hull(copy());
     }
+    basic_map simple_hull() &&
+    {
+        return isl_map_simple_hull(release());
+    }
     map equate(int in_dim, int out_dim) const
     {
         return isl_map_equate(copy(), isl_dim_in, in_dim, isl_dim_out, out_dim);
     }
-    set deltas() const
+    set deltas() const &
     {
         return isl_map_deltas(copy());
     }
+    set deltas() &&
+    {
+        return isl_map_deltas(release());
+    }
 
     void map_domain_through( const map & other )
     {
-        m_object = isl_map_apply_domain(m_object, other.copy());
+        update(isl_map_apply_domain(m_object, other.copy()));
     }
     void map_range_through( const map & other )
     {
-        m_object = isl_map_apply_range(m_object, other.copy());
+        update(isl_map_apply_range(m_object, other.copy()));
     }
     identifier id( space::dimension_type type ) const
     {
@@ -398,13 +484,13 @@ public:
     }
     void set_id( space::dimension_type type, const identifier & id )
     {
-        isl_id *c_id = id.c_id(m_ctx.get());
+        isl_id *c_id = id.c_id(ctx());
         if (c_id)
-            m_object = isl_map_set_tuple_id(get(), (isl_dim_type)type, c_id);
+            update(isl_map_set_tuple_id(get(), (isl_dim_type)type, c_id));
     }
     void set_name( space::dimension_type type, const string & name )
     {
-        m_object = isl_map_set_tuple_name(get(), (isl_dim_type)type, name.c_str());
+        update(isl_map_set_tuple_name(get(), (isl_dim_type)type, name.c_str()));
     }
     string name( space::dimension_type type ) const
     {
@@ -412,15 +498,15 @@ public:
     }
     void add_dimensions( space::dimension_type type, unsigned count )
     {
-        m_object = isl_map_add_dims(m_object, (isl_dim_type) type, count);
+        update(isl_map_add_dims(m_object, (isl_dim_type) type, count));
     }
     void insert_dimensions( space::dimension_type type, unsigned pos, unsigned count )
     {
-        m_object = isl_map_insert_dims(m_object, (isl_dim_type) type, pos, count);
+        update(isl_map_insert_dims(m_object, (isl_dim_type) type, pos, count));
     }
     void project_out_dimensions( space::dimension_type type, unsigned i, unsigned n=1 )
     {
-        m_object = isl_map_project_out(m_object, (isl_dim_type)type, i, n);
+        update(isl_map_project_out(m_object, (isl_dim_type)type, i, n));
     }
     void add_constraint( const constraint & c )
     {
@@ -428,12 +514,12 @@ public:
         if (c.local_space().is_wrapping())
             isl_c = isl_constraint_unwrap_local_space(isl_c);
 
-        m_object = isl_map_add_constraint(m_object, isl_c);
+        update(isl_map_add_constraint(m_object, isl_c));
     }
     void drop_constraints_with( space::dimension_type t, unsigned i, unsigned n=1)
     {
-        m_object = isl_map_drop_constraints_involving_dims
-                (m_object, (isl_dim_type) t, i, n);
+        update(isl_map_drop_constraints_involving_dims
+                (m_object, (isl_dim_type) t, i, n));
     }
 
     template <typename F>
@@ -478,36 +564,58 @@ public:
     }
     bool is_empty() const
     {
-        return isl_union_map_is_empty(get());
+        return cached_answer(*this, result_cache::is_empty_query, {},
+                             [&]{ return isl_union_map_is_empty(get()); });
     }
     bool is_subset_of(const union_map & other) const
     {
-        return isl_union_map_is_subset(get(), other.get());
+        return cached_answer(*this, result_cache::is_subset_query, other.get(),
+                             [&]{ return isl_union_map_is_subset(get(), other.get()); });
     }
     bool is_strict_subset_of(const union_map & other) const
     {
-        return isl_union_map_is_strict_subset(get(), other.get());
+        return checked(isl_union_map_is_strict_subset(get(), other.get()));
     }
-    union_set range() const
+    union_set range() const &
     {
         return isl_union_map_range(copy());
     }
-    union_set domain() const
+    union_set range() &&
+    {
+        return isl_union_map_range(release());
+    }
+    union_set domain() const &
     {
         return isl_union_map_domain(copy());
     }
-    union_map inverse() const
+    union_set domain() &&
+    {
+        return isl_union_map_domain(release());
+    }
+    union_map inverse() const &
     {
         return union_map( isl_union_map_reverse(copy()) );
     }
-    union_set wrapped() const
+    union_map inverse() &&
+    {
+        return union_map( isl_union_map_reverse(release()) );
+    }
+    union_set wrapped() const &
     {
         return isl_union_map_wrap(copy());
     }
-    union_map universe() const
+    union_set wrapped() &&
+    {
+        return isl_union_map_wrap(release());
+    }
+    union_map universe() const &
     {
         return isl_union_map_universe(copy());
     }
+    union_map universe() &&
+    {
+        return isl_union_map_universe(release());
+    }
     map map_for( const space & spc ) const
     {
         return isl_union_map_extract_map(get(), spc.copy());
@@ -516,24 +624,35 @@ public:
     {
         auto the_map = isl_map_from_union_map(copy());
         if (!the_map)
+        {
+            context::budget_scope::check();
             throw error("No single map.");
+        }
         return the_map;
     }
-    union_map in_domain( const union_set & domain ) const
+    union_map in_domain( const union_set & domain ) const &
     {
         return isl_union_map_intersect_domain(copy(), domain.copy());
     }
-    union_map in_range( const union_set & range ) const
+    union_map in_domain( const union_set & domain ) &&
+    {
+        return isl_union_map_intersect_domain(release(), domain.copy());
+    }
+    union_map in_range( const union_set & range ) const &
     {
         return isl_union_map_intersect_range(copy(), range.copy());
     }
+    union_map in_range( const union_set & range ) &&
+    {
+        return isl_union_map_intersect_range(release(), range.copy());
+    }
     void map_domain_through( const union_map & other )
     {
-        m_object = isl_union_map_apply_domain(m_object, other.copy());
+        update(isl_union_map_apply_domain(m_object, other.copy()));
     }
     void map_range_through( const union_map & other )
     {
-        m_object = isl_union_map_apply_range(m_object, other.copy());
+        update(isl_union_map_apply_range(m_object, other.copy()));
     }
 
     union_set operator() ( const union_set & arg ) const
@@ -547,25 +666,66 @@ public:
 
     union_map & subtract(const union_map & rhs)
     {
-        m_object = isl_union_map_subtract(m_object, rhs.copy());
+        update(isl_union_map_subtract(m_object, rhs.copy()));
         return *this;
     }
 
     void coalesce()
     {
-        m_object = isl_union_map_coalesce(m_object);
+        *this = cached_in_place_result<isl_union_map>(*this, result_cache::coalesce_query,
+                                                      [&]{ return isl_union_map_coalesce(release()); });
     }
 
-    union_set deltas()
+    union_set deltas() const &
     {
         return isl_union_map_deltas(copy());
     }
+    union_set deltas() &&
+    {
+        return isl_union_map_deltas(release());
+    }
+
+    union_map lex_minimum() const &
+    {
+        return cached_result<isl_union_map>(*this, result_cache::lex_minimum_query, {},
+                                            [&]{ return isl_union_map_lexmin(copy()); });
+    }
+    union_map lex_minimum() &&
+    {
+        return cached_result<isl_union_map>(*this, result_cache::lex_minimum_query, {},
+                                            [&]{ return isl_union_map_lexmin(release()); });
+    }
+    union_map lex_maximum() const &
+    {
+        return cached_result<isl_union_map>(*this, result_cache::lex_maximum_query, {},
+                                            [&]{ return isl_union_map_lexmax(copy()); });
+    }
+    union_map lex_maximum() &&
+    {
+        return cached_result<isl_union_map>(*this, result_cache::lex_maximum_query, {},
+                                            [&]{ return isl_union_map_lexmax(release()); });
+    }
 
     template <typename F>
     void for_each( F f ) const
     {
         isl_union_map_foreach_map(get(), &for_each_helper<F>, &f);
     }
+
+    // Calls f on each component in parallel, on the workers of the pool.
+    // Each component is passed to f in the context of its worker.
+    // Each worker calls its own copy of f, so state shared between
+    // the copies, such as variables captured by reference, must be
+    // safe to use from several threads at once.
+    // Defined in parallel.hpp.
+    template <typename F>
+    void parallel_for_each( worker_pool & pool, F f ) const;
+
+    // Like parallel_for_each, but collects the results of f
+    // into a union in the context of this one.
+    // Defined in parallel.hpp.
+    template <typename F>
+    union_map parallel_transform( worker_pool & pool, F f ) const;
 private:
     template <typename F>
     static isl_stat for_each_helper(isl_map *map_ptr, void *data_ptr)
@@ -596,25 +756,40 @@ basic_map operator& (const basic_map & lhs, const basic_map & rhs)
     return isl_basic_map_intersect(lhs.copy(), rhs.copy());
 }
 inline
+basic_map operator& (basic_map && lhs, const basic_map & rhs)
+{
+    return isl_basic_map_intersect(lhs.release(), rhs.copy());
+}
+inline
 map operator& (const map & lhs, const map & rhs)
 {
     return isl_map_intersect(lhs.copy(), rhs.copy());
 }
 inline
+map operator& (map && lhs, const map & rhs)
+{
+    return isl_map_intersect(lhs.release(), rhs.copy());
+}
+inline
 union_map operator& (const union_map & lhs, const union_map & rhs)
 {
     return isl_union_map_intersect(lhs.copy(), rhs.copy());
 }
 inline
+union_map operator& (union_map && lhs, const union_map & rhs)
+{
+    return isl_union_map_intersect(lhs.release(), rhs.copy());
+}
+inline
 map & operator&=(map & lhs, const map & rhs )
 {
-    lhs = lhs & rhs;
+    lhs = std::move(lhs) & rhs;
     return lhs;
 }
 inline
 union_map & operator&=(union_map & lhs, const union_map & rhs )
 {
-    lhs = lhs & rhs;
+    lhs = std::move(lhs) & rhs;
     return lhs;
 }
 
@@ -623,7 +798,21 @@ map operator| (const map &lhs, const map & rhs)
 {
     auto u = isl_map_union(lhs.copy(), rhs.copy());
     if (!u)
+    {
+        context::budget_scope::check();
+        throw error();
+    }
+    return u;
+}
+inline
+map operator| (map && lhs, const map & rhs)
+{
+    auto u = isl_map_union(lhs.release(), rhs.copy());
+    if (!u)
+    {
+        context::budget_scope::check();
         throw error();
+    }
     return u;
 }
 
@@ -633,25 +822,40 @@ union_map operator| (const union_map &lhs, const union_map & rhs)
     return isl_union_map_union(lhs.copy(), rhs.copy());
 }
 inline
+union_map operator| (union_map && lhs, const union_map & rhs)
+{
+    return isl_union_map_union(lhs.release(), rhs.copy());
+}
+inline
 union_map operator| (const union_map &lhs, const map & rhs)
 {
     return isl_union_map_union(lhs.copy(), isl_union_map_from_map(rhs.copy()));
 }
 inline
+union_map operator| (union_map && lhs, const map & rhs)
+{
+    return isl_union_map_union(lhs.release(), isl_union_map_from_map(rhs.copy()));
+}
+inline
 union_map operator| (const union_map &lhs, const basic_map & rhs)
 {
     return isl_union_map_union(lhs.copy(), isl_union_map_from_basic_map(rhs.copy()));
 }
 inline
+union_map operator| (union_map && lhs, const basic_map & rhs)
+{
+    return isl_union_map_union(lhs.release(), isl_union_map_from_basic_map(rhs.copy()));
+}
+inline
 map & operator|=(map & lhs, const map & rhs )
 {
-    lhs = lhs | rhs;
+    lhs = std::move(lhs) | rhs;
     return lhs;
 }
 inline
 union_map & operator|=(union_map & lhs, const union_map & rhs )
 {
-    lhs = lhs | rhs;
+    lhs = std::move(lhs) | rhs;
     return lhs;
 }
 
@@ -660,6 +864,11 @@ map operator* ( const map & lhs, const map & rhs )
 {
     return isl_map_range_product(lhs.copy(), rhs.copy());
 }
+inline
+map operator* ( map && lhs, const map & rhs )
+{
+    return isl_map_range_product(lhs.release(), rhs.copy());
+}
 
 template <> inline
 void printer::print<basic_map>( const basic_map & m )
@@ -677,23 +886,100 @@ void printer::print<union_map>( const union_map & m )
     m_printer = isl_printer_print_union_map(m_printer, m.get());
 }
 
+namespace detail {
+
+// Compares the representations of two maps, like isl_set_plain_cmp.
+// isl has no plain comparison of maps, so they are compared
+// as wrapped sets.
+inline
+int plain_cmp( const map & lhs, const map & rhs )
+{
+    if (lhs.get() == rhs.get())
+        return 0;
+    isl_set * a = isl_map_wrap(lhs.copy());
+    isl_set * b = isl_map_wrap(rhs.copy());
+    int cmp = isl_set_plain_cmp(a, b);
+    isl_set_free(a);
+    isl_set_free(b);
+    return cmp;
+}
+
+}
+
+inline
+bool operator==( const map & lhs, const map & rhs)
+{
+    if (lhs.get() == rhs.get())
+        return true;
+    if (checked(isl_map_plain_is_equal(lhs.get(), rhs.get())))
+        return true;
+    return checked(isl_map_is_equal(lhs.get(), rhs.get()));
+}
+
+inline
+bool operator!=( const map & lhs, const map & rhs)
+{
+    return !(lhs == rhs);
+}
+
+// Orders maps by their representation, like sets.
+inline
+bool operator<( const map & lhs, const map & rhs)
+{
+    return detail::plain_cmp(lhs, rhs) < 0;
+}
+
+template <>
+struct plain_equal<map>
+{
+    bool operator()( const map & lhs, const map & rhs ) const
+    {
+        return detail::plain_cmp(lhs, rhs) == 0;
+    }
+};
+
 template <> inline
 void printer::print_each_in<map>(const map & u)
 {
     u.for_each([this](const basic_map & m){
-        print(m); std::cout << std::endl;
+        print(m); end_line();
         return true;
     });
 }
 
+template <> inline
+void printer::print_all<map>(const map & u)
+{
+    print_each_in(u);
+    flush();
+}
+
 template <> inline
 void printer::print_each_in<union_map>(const union_map & u)
 {
     u.for_each([this](const map & m){
-        print(m); std::cout << std::endl;
+        print(m); end_line();
         return true;
     });
 }
 
+template <> inline
+void printer::print_all<union_map>(const union_map & u)
+{
+    print_each_in(u);
+    flush();
+}
+
 }
+
+namespace std {
+
+template<>
+struct hash<isl::map>
+{
+    size_t operator()( const isl::map & m ) const { return m.hash(); }
+};
+
+}
+
 #endif // ISL_CPP_MAP_INCLUDED
@@ -19,13 +19,215 @@ along with this program; if not, write to the Free Software Foundation, Inc.,
 */
 
 #include "matrix.hpp"
+#include "integer.hpp"
 
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <climits>
+#include <cstdlib>
 
 namespace isl {
 
+namespace {
+
+const size_t limb_size = sizeof(uint64_t);
+
+}
+
+using detail::int64_val;
+using detail::take_int64;
+
+bool column_vector::to_int64( std::vector<int64_t> & data ) const
+{
+    int n = size();
+    data.resize(n);
+
+    bool all_fit = true;
+    for (int i = 0; i < n; ++i)
+    {
+        if (!take_int64(isl_vec_get_element_val(get(), i), data[i]))
+            all_fit = false;
+    }
+    return all_fit;
+}
+
+column_vector column_vector::from_int64( const context & ctx, unsigned size,
+                                         const int64_t * data )
+{
+    isl_ctx * c_ctx = ctx.get();
+    isl_vec * v = isl_vec_alloc(c_ctx, size);
+    for (unsigned i = 0; i < size; ++i)
+    {
+        int64_t x = data[i];
+        if (x >= INT_MIN && x <= INT_MAX)
+            v = isl_vec_set_element_si(v, i, (int) x);
+        else
+            v = isl_vec_set_element_val(v, i, int64_val(c_ctx, x));
+    }
+    return column_vector(v);
+}
+
+bool matrix::to_int64( std::vector<int64_t> & data ) const
+{
+    isl_mat * m = get();
+    int rows = row_count();
+    int cols = column_count();
+
+    data.resize(rows * cols);
+
+    bool all_fit = true;
+    int64_t * out = data.data();
+    for (int r = 0; r < rows; ++r)
+    {
+        for (int c = 0; c < cols; ++c, ++out)
+        {
+            if (!take_int64(isl_mat_get_element_val(m, r, c), *out))
+                all_fit = false;
+        }
+    }
+
+    return all_fit;
+}
+
+matrix matrix::from_int64( const context & ctx, unsigned rows, unsigned columns,
+                           const int64_t * data )
+{
+    isl_ctx * c_ctx = ctx.get();
+    isl_mat * m = isl_mat_alloc(c_ctx, rows, columns);
+    for (unsigned r = 0; r < rows; ++r)
+    {
+        for (unsigned c = 0; c < columns; ++c, ++data)
+        {
+            int64_t x = *data;
+            if (x >= INT_MIN && x <= INT_MAX)
+                m = isl_mat_set_element_si(m, r, c, (int) x);
+            else
+                m = isl_mat_set_element_val(m, r, c, int64_val(c_ctx, x));
+        }
+    }
+    return matrix(m);
+}
+
+matrix matrix::right_inverse() const
+{
+    int rows = row_count();
+    int cols = column_count();
+
+    // this * U = [L 0] with L lower triangular. There is an integer
+    // right inverse only if L has a unit diagonal, and it is then
+    // U restricted to the first columns, times the inverse of L.
+    isl_mat * u = nullptr;
+    isl_mat * h = isl_mat_left_hermite(copy(), 0, &u, nullptr);
+    if (!h || !u)
+    {
+        isl_mat_free(h);
+        isl_mat_free(u);
+        context::budget_scope::check();
+        throw error("Can not compute Hermite form.");
+    }
+
+    bool invertible = rows <= cols;
+    for (int i = 0; invertible && i < rows; ++i)
+    {
+        isl_val * d = isl_mat_get_element_val(h, i, i);
+        invertible = isl_val_is_one(d) == isl_bool_true;
+        isl_val_free(d);
+    }
+    if (!invertible)
+    {
+        isl_mat_free(h);
+        isl_mat_free(u);
+        throw error("Matrix has no integer right inverse.");
+    }
+
+    h = isl_mat_drop_cols(h, rows, cols - rows);
+    u = isl_mat_drop_cols(u, rows, cols - rows);
+    return isl_mat_product(u, isl_mat_right_inverse(h));
+}
+
+matrix::hermite_form matrix::left_hermite() const
+{
+    isl_mat * u = nullptr;
+    isl_mat * q = nullptr;
+    isl_mat * h = isl_mat_left_hermite(copy(), 0, &u, &q);
+    return { matrix(h), matrix(u), matrix(q) };
+}
+
+matrix::hermite_form matrix::right_hermite() const
+{
+    // The transpose of the left Hermite form of the transpose.
+    hermite_form f = transpose().left_hermite();
+    return { f.h.transpose(), f.u.transpose(), f.q.transpose() };
+}
+
+void matrix::to_integers( integer_buffer & data ) const
+{
+    isl_mat * m = get();
+    int rows = row_count();
+    int cols = column_count();
+
+    data.limbs.clear();
+    data.sizes.resize(rows * cols);
+
+    int * size = data.sizes.data();
+    for (int r = 0; r < rows; ++r)
+    {
+        for (int c = 0; c < cols; ++c, ++size)
+        {
+            isl_val * v = isl_mat_get_element_val(m, r, c);
+
+            int n = isl_val_is_zero(v) == isl_bool_true ?
+                        0 : isl_val_n_abs_num_chunks(v, limb_size);
+            if (n > 0)
+            {
+                size_t start = data.limbs.size();
+                data.limbs.resize(start + n);
+                isl_val_get_abs_num_chunks(v, limb_size, &data.limbs[start]);
+            }
+            *size = isl_val_is_neg(v) == isl_bool_true ? -n : n;
+
+            isl_val_free(v);
+        }
+    }
+}
+
+matrix matrix::from_integers( const context & ctx, unsigned rows, unsigned columns,
+                              const integer_buffer & data )
+{
+    isl_ctx * c_ctx = ctx.get();
+    isl_mat * m = isl_mat_alloc(c_ctx, rows, columns);
+
+    const uint64_t * limbs = data.limbs.data();
+    const int * size = data.sizes.data();
+    for (unsigned r = 0; r < rows; ++r)
+    {
+        for (unsigned c = 0; c < columns; ++c, ++size)
+        {
+            int n = std::abs(*size);
+            if (n == 0)
+            {
+                m = isl_mat_set_element_si(m, r, c, 0);
+                continue;
+            }
+            if (n == 1 && *limbs <= uint64_t(INT_MAX))
+            {
+                int x = int(*limbs);
+                m = isl_mat_set_element_si(m, r, c, *size < 0 ? -x : x);
+            }
+            else
+            {
+                isl_val * v = isl_val_int_from_chunks(c_ctx, n, limb_size, limbs);
+                if (*size < 0)
+                    v = isl_val_neg(v);
+                m = isl_mat_set_element_val(m, r, c, v);
+            }
+            limbs += n;
+        }
+    }
+    return matrix(m);
+}
+
 void print( const matrix & m, int field_width )
 {
     using namespace std;
@@ -33,6 +235,9 @@ void print( const matrix & m, int field_width )
     int rows = m.row_count();
     int cols = m.column_count();
 
+    vector<int64_t> data;
+    bool all_fit = m.to_int64(data);
+
     for(int r = 0; r < rows; ++r)
     {
         for(int c = 0; c < cols; ++c)
@@ -40,15 +245,21 @@ void print( const matrix & m, int field_width )
             if (c > 0)
                 cout << " ";
 
-            auto val = m(r, c).value();
-
             ostringstream text;
-            text << val.numerator();
-            if (val.denominator() != 1)
-                text << "/" << val.denominator();
+            if (all_fit)
+            {
+                text << data[r * cols + c];
+            }
+            else
+            {
+                auto val = m(r, c).value();
+                text << val.numerator();
+                if (val.denominator() != 1)
+                    text << "/" << val.denominator();
+            }
 
             string str = text.str();
-            if (str.size() <= field_width)
+            if (str.size() <= (std::size_t) field_width)
                 cout << setw(field_width) << str;
             else
                 cout << string(field_width, '.');
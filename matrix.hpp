@@ -27,6 +27,10 @@ along with this program; if not, write to the Free Software Foundation, Inc.,
 #include "printer.hpp"
 
 #include <isl/mat.h>
+#include <isl/vec.h>
+
+#include <vector>
+#include <cstdint>
 
 namespace isl {
 
@@ -47,6 +51,56 @@ struct object_behavior<isl_mat>
     }
 };
 
+template<>
+struct object_behavior<isl_vec>
+{
+    static isl_vec * copy( isl_vec * obj )
+    {
+        return isl_vec_copy(obj);
+    }
+    static void destroy( isl_vec *obj )
+    {
+        isl_vec_free(obj);
+    }
+    static isl_ctx * get_context( isl_vec * obj )
+    {
+        return isl_vec_get_ctx(obj);
+    }
+};
+
+class column_vector : public object<isl_vec>
+{
+public:
+    column_vector(isl_vec *ptr): object(ptr) {}
+    // Initialized to zero.
+    column_vector( const context & ctx, unsigned size ):
+        object(ctx, isl_vec_zero(ctx.get(), size))
+    {}
+
+    int size() const { return isl_vec_size(get()); }
+
+    isl::value operator[]( int i ) const
+    {
+        return isl_vec_get_element_val(get(), i);
+    }
+
+    void set( int i, int v )
+    {
+        update(isl_vec_set_element_si(m_object, i, v));
+    }
+
+    void set( int i, const value & v )
+    {
+        update(isl_vec_set_element_val(m_object, i, v.copy()));
+    }
+
+    // Returns false if some element does not fit in 64 bits;
+    // such elements are stored as zero.
+    bool to_int64( std::vector<int64_t> & data ) const;
+    static column_vector from_int64( const context & ctx, unsigned size,
+                                     const int64_t * data );
+};
+
 class matrix : public object<isl_mat>
 {
 public:
@@ -78,6 +132,16 @@ public:
         {}
     };
 
+    // Integers of any size, stored back to back as the 64-bit limbs
+    // of their magnitudes, least significant limb first.
+    struct integer_buffer
+    {
+        std::vector<uint64_t> limbs;
+        // The number of limbs of each integer, negated if
+        // the integer is negative. Zero has no limbs.
+        std::vector<int> sizes;
+    };
+
     matrix(isl_mat *ptr): object(ptr) {}
     // Does not initialize!
     matrix( const context & ctx, unsigned rows, unsigned columns ):
@@ -100,6 +164,18 @@ public:
     int row_count() const { return isl_mat_rows(get()); }
     int column_count() const { return isl_mat_cols(get()); }
 
+    // Bulk access to all elements in row-major order.
+    //
+    // to_int64 returns false if some element does not fit
+    // in 64 bits; such elements are stored as zero.
+    bool to_int64( std::vector<int64_t> & data ) const;
+    static matrix from_int64( const context & ctx, unsigned rows, unsigned columns,
+                              const int64_t * data );
+
+    void to_integers( integer_buffer & data ) const;
+    static matrix from_integers( const context & ctx, unsigned rows, unsigned columns,
+                                 const integer_buffer & data );
+
     element operator() (int row, int column)
     {
         return element(get(), row, column);
@@ -115,6 +191,65 @@ public:
         return isl_mat_right_kernel(copy());
     }
 
+    // Linear algebra over the integers.
+    //
+    // These work on the isl matrix as a whole and never
+    // go through isl::value for single elements.
+
+    matrix transpose() const
+    {
+        return isl_mat_transpose(copy());
+    }
+
+    static matrix product( const matrix & a, const matrix & b )
+    {
+        if (a.column_count() != b.row_count())
+            throw error("Matrix dimensions do not match.");
+        return isl_mat_product(a.copy(), b.copy());
+    }
+
+    column_vector operator*( const column_vector & v ) const
+    {
+        if (column_count() != v.size())
+            throw error("Matrix and vector dimensions do not match.");
+        return isl_mat_vec_product(copy(), v.copy());
+    }
+
+    int rank() const { return isl_mat_rank(get()); }
+
+    // Returns an integer matrix R such that this * R is the identity.
+    // Throws if there is none, that is if the rows do not span
+    // the whole integer lattice, and also if isl fails.
+    matrix right_inverse() const;
+
+    // Returns an integer matrix L such that L * this is the identity.
+    matrix left_inverse() const
+    {
+        return transpose().right_inverse().transpose();
+    }
+
+    // H = M * U in column echelon form (left)
+    // or H = U * M in row echelon form (right),
+    // with U unimodular and Q its inverse.
+    struct hermite_form;
+
+    hermite_form left_hermite() const;
+    hermite_form right_hermite() const;
+
+    // Returns a square unimodular matrix whose first rows are the rows
+    // of this matrix. The rows must be extendable, for example a single
+    // row whose elements have no common divisor.
+    matrix unimodular_complete() const
+    {
+        int rows = row_count();
+        int cols = column_count();
+        if (rows > cols)
+            throw error("Matrix has more rows than columns.");
+
+        isl_mat * m = isl_mat_insert_zero_rows(copy(), rows, cols - rows);
+        return isl_mat_unimodular_complete(m, rows);
+    }
+
     matrix nullspace() const
     {
         return right_kernel();
@@ -122,59 +257,93 @@ public:
 
     void drop_column(int col)
     {
-        int n_rows = row_count();
-        int n_cols = column_count() - 1;
+        drop_columns(col, 1);
+    }
 
-        auto result = isl_mat_alloc(ctx().get(),
-                                    n_rows, n_cols);
+    void drop_columns(unsigned first, unsigned n)
+    {
+        update(isl_mat_drop_cols(m_object, first, n));
+    }
 
-        for (int r = 0; r < n_rows; ++r)
-        {
-            for (int c = 0; c < col; ++c)
-            {
-                auto val = isl_mat_get_element_val(get(), r, c);
-                result = isl_mat_set_element_val(result, r, c, val);
-            }
+    void drop_rows(unsigned first, unsigned n)
+    {
+        update(isl_mat_drop_rows(m_object, first, n));
+    }
 
-            for (int c = col; c < n_cols; ++c)
-            {
-                auto val = isl_mat_get_element_val(get(), r, c+1);
-                result = isl_mat_set_element_val(result, r, c, val);
-            }
-        }
+    void insert_zero_columns(unsigned first, unsigned n)
+    {
+        update(isl_mat_insert_zero_cols(m_object, first, n));
+    }
+
+    void insert_zero_rows(unsigned first, unsigned n)
+    {
+        update(isl_mat_insert_zero_rows(m_object, first, n));
+    }
 
-        isl_mat_free(m_object);
+    void swap_columns(unsigned i, unsigned j)
+    {
+        update(isl_mat_swap_cols(m_object, i, j));
+    }
 
-        m_object = result;
+    void swap_rows(unsigned i, unsigned j)
+    {
+        update(isl_mat_swap_rows(m_object, i, j));
     }
 
-    static matrix concatenate_vertically(const matrix & a, const matrix & b)
+    matrix submatrix(unsigned first_row, unsigned first_column,
+                     unsigned rows, unsigned columns) const
     {
-        if (a.column_count() != b.column_count())
+        if (first_row + rows > (unsigned) row_count() ||
+                first_column + columns > (unsigned) column_count())
+            throw error("Submatrix out of bounds.");
+
+        isl_mat * m = copy();
+        m = isl_mat_drop_rows(m, first_row + rows, row_count() - first_row - rows);
+        m = isl_mat_drop_rows(m, 0, first_row);
+        m = isl_mat_drop_cols(m, first_column + columns,
+                              column_count() - first_column - columns);
+        m = isl_mat_drop_cols(m, 0, first_column);
+        return m;
+    }
+
+    static matrix concat_vertical(const matrix & top, const matrix & bottom)
+    {
+        if (top.column_count() != bottom.column_count())
             throw error("Matrices do not have equal number of columns");
 
-        auto result = isl::matrix(a.get_context(),
-                                  a.row_count() + b.row_count(),
-                                  a.column_count());
+        return isl_mat_concat(top.copy(), bottom.copy());
+    }
 
-        for (int row = 0; row < a.row_count(); ++row)
-        {
-            for (int col = 0; col < a.column_count(); ++col)
-            {
-                result(row,col) = a(row,col).value();
-            }
-        }
-        for (int row = 0; row < b.row_count(); ++row)
-        {
-            for (int col = 0; col < b.column_count(); ++col)
-            {
-                result(a.row_count() + row, col) = b(row,col).value();
-            }
-        }
-        return result;
+    // isl only concatenates rows, so this goes through the transposes.
+    static matrix concat_horizontal(const matrix & left, const matrix & right)
+    {
+        if (left.row_count() != right.row_count())
+            throw error("Matrices do not have equal number of rows");
+
+        isl_mat * m = isl_mat_concat(isl_mat_transpose(left.copy()),
+                                     isl_mat_transpose(right.copy()));
+        return isl_mat_transpose(m);
+    }
+
+    static matrix concatenate_vertically(const matrix & a, const matrix & b)
+    {
+        return concat_vertical(a, b);
     }
 };
 
+struct matrix::hermite_form
+{
+    matrix h;
+    matrix u;
+    matrix q;
+};
+
+inline
+matrix operator*( const matrix & a, const matrix & b )
+{
+    return matrix::product(a, b);
+}
+
 void print( const matrix & m, int field_width = 4 );
 
 }
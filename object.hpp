@@ -23,53 +23,160 @@ along with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include "context.hpp"
 
+#include <utility>
+
 namespace isl {
 
 template <typename T>
 struct object_behavior
 {};
 
+// By default, each object holds a reference to its context, which keeps
+// the context alive for as long as any of its objects exist.
+//
+// With ISL_CPP_COMPACT_HANDLES defined, an object holds nothing but the
+// isl pointer and has no virtual destructor. The context is looked up
+// from the isl object only when ctx() is called, so the isl::context
+// must outlive all objects created in it.
+
 template <typename T>
 class object
 {
 public:
+#ifdef ISL_CPP_COMPACT_HANDLES
+    ~object()
+    {
+        static_assert(sizeof(object<T>) == sizeof(T*),
+                      "Compact object must be one pointer wide.");
+        object_behavior<T>::destroy(m_object);
+    }
+
+    context ctx() const { return object_behavior<T>::get_context(m_object); }
+#else
     virtual ~object()
     {
         object_behavior<T>::destroy(m_object);
     }
 
     const context & ctx() const { return m_ctx; }
+#endif
 
     bool is_valid() const { return m_object != nullptr; }
-    T * get() const { return m_object; }
-    T * copy() const { return object_behavior<T>::copy(m_object); }
+
+    T * get() const
+    {
+        if (!m_object)
+            context::budget_scope::check();
+        return m_object;
+    }
+
+    T * copy() const
+    {
+        return object_behavior<T>::copy(get());
+    }
+
+    // Gives up ownership of the isl object, leaving this one invalid.
+    T * release()
+    {
+        T * obj = m_object;
+        m_object = nullptr;
+        return obj;
+    }
 
     object<T> & operator= ( const object<T> & other )
     {
         if (m_object != other.m_object)
         {
             object_behavior<T>::destroy(m_object);
+#ifndef ISL_CPP_COMPACT_HANDLES
             m_ctx = other.m_ctx;
+#endif
             m_object = other.copy();
         }
         return *this;
     }
 
+    object<T> & operator= ( object<T> && other )
+    {
+        if (this != &other)
+        {
+            object_behavior<T>::destroy(m_object);
+#ifndef ISL_CPP_COMPACT_HANDLES
+            m_ctx = std::move(other.m_ctx);
+#endif
+            m_object = other.release();
+        }
+        return *this;
+    }
+
+protected:
+    // Takes the result of an isl call that consumed the object,
+    // throwing at once if the call failed inside a budget_scope.
+    void update( T * obj )
+    {
+        m_object = obj;
+        if (!obj)
+            context::budget_scope::check();
+    }
 
+public:
+#ifdef ISL_CPP_COMPACT_HANDLES
+    object( const context &, T * obj ):
+        m_object(obj)
+    {
+        if (!obj)
+            context::budget_scope::check();
+    }
+
+    object( const object<T> & other ):
+        m_object(other.copy())
+    {}
+
+    object( object<T> && other ):
+        m_object(other.release())
+    {}
+
+    object( T * other_obj ):
+        m_object( other_obj )
+    {
+        if (!other_obj)
+            context::budget_scope::check();
+    }
+
+    struct copy_of {};
+
+    object(copy_of, T * p):
+        m_object(object_behavior<T>::copy(p))
+    {}
+
+protected:
+    T* m_object;
+#else
     object( const context & ctx, T * obj ):
         m_ctx(ctx),
         m_object(obj)
-    {}
+    {
+        if (!obj)
+            context::budget_scope::check();
+    }
 
     object( const object<T> & other ):
         m_ctx(other.m_ctx),
         m_object(other.copy())
     {}
 
+    object( object<T> && other ):
+        m_ctx(std::move(other.m_ctx)),
+        m_object(other.release())
+    {}
+
     object( T * other_obj ):
         m_ctx( object_behavior<T>::get_context(other_obj) ),
         m_object( other_obj )
-    {}
+    {
+        if (!other_obj)
+            context::budget_scope::check();
+    }
 
     struct copy_of {};
 
@@ -81,6 +188,7 @@ public:
 protected:
     context m_ctx;
     T* m_object;
+#endif
 };
 
 }
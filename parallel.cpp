@@ -0,0 +1,105 @@
+/*
+isl-cpp: C++ bindings to the ISL (Integer Set Library)
+
+Copyright (C) 2014  Jakob Leben <jakob.leben@gmail.com>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "parallel.hpp"
+
+namespace isl {
+
+worker_pool::worker_pool( int size ):
+    m_contexts(size)
+{
+    for (int i = 0; i < size; ++i)
+        m_threads.emplace_back(&worker_pool::work, this, i);
+}
+
+worker_pool::~worker_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_job_ready.notify_all();
+
+    for (auto & thread : m_threads)
+        thread.join();
+}
+
+void worker_pool::run( const std::function<void(int)> & job )
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_pending = size();
+        m_error = nullptr;
+        ++m_generation;
+    }
+    m_job_ready.notify_all();
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_job_done.wait(lock, [this]{ return m_pending == 0; });
+        m_job = nullptr;
+        std::swap(error, m_error);
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void worker_pool::work( int index )
+{
+    unsigned generation = 0;
+
+    for(;;)
+    {
+        const std::function<void(int)> * job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_job_ready.wait(lock, [&]{
+                return m_stopping || m_generation != generation;
+            });
+            if (m_stopping)
+                return;
+            generation = m_generation;
+            job = m_job;
+        }
+
+        std::exception_ptr error;
+        try
+        {
+            (*job)(index);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (error && !m_error)
+                m_error = error;
+            if (--m_pending == 0)
+                m_job_done.notify_all();
+        }
+    }
+}
+
+}
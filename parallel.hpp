@@ -0,0 +1,167 @@
+/*
+isl-cpp: C++ bindings to the ISL (Integer Set Library)
+
+Copyright (C) 2014  Jakob Leben <jakob.leben@gmail.com>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef ISL_CPP_PARALLEL_INCLUDED
+#define ISL_CPP_PARALLEL_INCLUDED
+
+#include "context.hpp"
+#include "set.hpp"
+#include "map.hpp"
+#include "transfer.hpp"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <utility>
+#include <vector>
+
+namespace isl {
+
+// A fixed set of worker threads, each with its own context.
+//
+// isl objects can not be shared between threads, so work is handed
+// to workers by transferring objects into their contexts before a job
+// starts and transferring results back after it has finished.
+
+class worker_pool
+{
+public:
+    explicit worker_pool( int size = default_size() );
+    ~worker_pool();
+
+    worker_pool( const worker_pool & ) = delete;
+    worker_pool & operator=( const worker_pool & ) = delete;
+
+    static int default_size()
+    {
+        int n = std::thread::hardware_concurrency();
+        return n > 0 ? n : 1;
+    }
+
+    int size() const { return (int) m_contexts.size(); }
+
+    // The context of a worker may only be used from outside the
+    // worker while no job is running.
+    context & worker_context( int index ) { return m_contexts[index]; }
+
+    // Calls job(i) on worker i, for each worker, and waits until all
+    // are done. The first exception thrown by a job is rethrown.
+    // Not reentrant.
+    void run( const std::function<void(int)> & job );
+
+private:
+    void work( int index );
+
+    std::vector<context> m_contexts;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_job_ready;
+    std::condition_variable m_job_done;
+    const std::function<void(int)> * m_job = nullptr;
+    unsigned m_generation = 0;
+    int m_pending = 0;
+    bool m_stopping = false;
+    std::exception_ptr m_error;
+};
+
+namespace detail {
+
+// Distributes the components of a union round-robin among the workers,
+// transferring each one into the context of its worker.
+template <typename U, typename T>
+std::vector<std::vector<T>> distribute( const U & u, worker_pool & pool )
+{
+    std::vector<std::vector<T>> batches(pool.size());
+    int index = 0;
+    u.for_each([&](const T & component){
+        int worker = index++ % pool.size();
+        batches[worker].push_back(transfer(component, pool.worker_context(worker)));
+        return true;
+    });
+    return batches;
+}
+
+// Each worker calls its own copy of f.
+
+template <typename U, typename T, typename F>
+void parallel_for_each( const U & u, worker_pool & pool, const F & f )
+{
+    auto batches = distribute<U,T>(u, pool);
+    pool.run([&](int worker){
+        F worker_f(f);
+        for (const T & component : batches[worker])
+            worker_f(component);
+    });
+}
+
+template <typename U, typename T, typename F>
+U parallel_transform( const U & u, worker_pool & pool, const F & f )
+{
+    typedef decltype(std::declval<F &>()(std::declval<const T &>())) result_type;
+
+    auto batches = distribute<U,T>(u, pool);
+    std::vector<std::vector<result_type>> results(pool.size());
+    pool.run([&](int worker){
+        F worker_f(f);
+        for (const T & component : batches[worker])
+            results[worker].push_back(worker_f(component));
+    });
+
+    U result(u.get_space());
+    for (const auto & batch : results)
+    {
+        for (const auto & r : batch)
+            result |= transfer(r, u.ctx());
+    }
+    return result;
+}
+
+}
+
+template <typename F>
+void union_set::parallel_for_each( worker_pool & pool, F f ) const
+{
+    detail::parallel_for_each<union_set, set>(*this, pool, f);
+}
+
+template <typename F>
+union_set union_set::parallel_transform( worker_pool & pool, F f ) const
+{
+    return detail::parallel_transform<union_set, set>(*this, pool, f);
+}
+
+template <typename F>
+void union_map::parallel_for_each( worker_pool & pool, F f ) const
+{
+    detail::parallel_for_each<union_map, map>(*this, pool, f);
+}
+
+template <typename F>
+union_map union_map::parallel_transform( worker_pool & pool, F f ) const
+{
+    return detail::parallel_transform<union_map, map>(*this, pool, f);
+}
+
+}
+
+#endif // ISL_CPP_PARALLEL_INCLUDED
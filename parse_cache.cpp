@@ -0,0 +1,171 @@
+/*
+isl-cpp: C++ bindings to the ISL (Integer Set Library)
+
+Copyright (C) 2014  Jakob Leben <jakob.leben@gmail.com>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "parse_cache.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+
+namespace isl {
+
+namespace {
+
+template <typename T>
+struct parse_behavior
+{};
+
+template <>
+struct parse_behavior<isl_set>
+{
+    static isl_set * read( isl_ctx * ctx, const char * text )
+    { return isl_set_read_from_str(ctx, text); }
+};
+
+template <>
+struct parse_behavior<isl_map>
+{
+    static isl_map * read( isl_ctx * ctx, const char * text )
+    { return isl_map_read_from_str(ctx, text); }
+};
+
+template <>
+struct parse_behavior<isl_union_set>
+{
+    static isl_union_set * read( isl_ctx * ctx, const char * text )
+    { return isl_union_set_read_from_str(ctx, text); }
+};
+
+template <>
+struct parse_behavior<isl_union_map>
+{
+    static isl_union_map * read( isl_ctx * ctx, const char * text )
+    { return isl_union_map_read_from_str(ctx, text); }
+};
+
+// FNV-1a, so texts can be looked up without copying them.
+std::size_t text_hash( const char * text, std::size_t length )
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (std::size_t i = 0; i < length; ++i)
+    {
+        hash ^= static_cast<unsigned char>(text[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+template <typename T>
+class table
+{
+public:
+    ~table() { clear(); }
+
+    // Returns a new reference to the object parsed from text.
+    T * parse( isl_ctx * ctx, const char * text, std::size_t length,
+               parse_cache::statistics & stats )
+    {
+        std::size_t hash = text_hash(text, length);
+
+        auto range = m_objects.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            const std::string & key = it->second.text;
+            if (key.size() == length && key.compare(0, length, text, length) == 0)
+            {
+                ++stats.hits;
+                return object_behavior<T>::copy(it->second.object);
+            }
+        }
+
+        ++stats.misses;
+
+        // isl needs null-terminated text.
+        entry e { std::string(text, length), nullptr };
+        e.object = parse_behavior<T>::read(ctx, e.text.c_str());
+        if (!e.object)
+            return nullptr;
+
+        T * result = object_behavior<T>::copy(e.object);
+        m_objects.emplace(hash, std::move(e));
+        ++stats.entries;
+        return result;
+    }
+
+    void clear()
+    {
+        for (auto & entry : m_objects)
+            object_behavior<T>::destroy(entry.second.object);
+        m_objects.clear();
+    }
+
+private:
+    struct entry
+    {
+        std::string text;
+        T * object;
+    };
+
+    std::unordered_multimap<std::size_t, entry> m_objects;
+};
+
+}
+
+struct parse_cache::tables
+{
+    table<isl_set> sets;
+    table<isl_map> maps;
+    table<isl_union_set> union_sets;
+    table<isl_union_map> union_maps;
+};
+
+parse_cache::parse_cache(): d(new tables) {}
+
+parse_cache::~parse_cache() {}
+
+set parse_cache::parse_set( const context & ctx, const char * text, std::size_t length )
+{
+    return d->sets.parse(ctx.get(), text, length, m_stats);
+}
+
+map parse_cache::parse_map( const context & ctx, const char * text, std::size_t length )
+{
+    return d->maps.parse(ctx.get(), text, length, m_stats);
+}
+
+union_set parse_cache::parse_union_set( const context & ctx, const char * text, std::size_t length )
+{
+    return d->union_sets.parse(ctx.get(), text, length, m_stats);
+}
+
+union_map parse_cache::parse_union_map( const context & ctx, const char * text, std::size_t length )
+{
+    return d->union_maps.parse(ctx.get(), text, length, m_stats);
+}
+
+void parse_cache::clear()
+{
+    d->sets.clear();
+    d->maps.clear();
+    d->union_sets.clear();
+    d->union_maps.clear();
+    m_stats = statistics();
+}
+
+}
@@ -0,0 +1,147 @@
+/*
+isl-cpp: C++ bindings to the ISL (Integer Set Library)
+
+Copyright (C) 2014  Jakob Leben <jakob.leben@gmail.com>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef ISL_CPP_PARSE_CACHE_INCLUDED
+#define ISL_CPP_PARSE_CACHE_INCLUDED
+
+#include "context.hpp"
+#include "set.hpp"
+#include "map.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace isl {
+
+// Objects parsed from text, kept per context and keyed by the text.
+// Parsing the same text again returns a new reference to the same
+// isl object instead of parsing it again.
+//
+// Texts that fail to parse are not remembered.
+
+class parse_cache
+{
+public:
+    struct statistics
+    {
+        unsigned long hits = 0;
+        unsigned long misses = 0;
+        std::size_t entries = 0;
+
+        double hit_rate() const
+        {
+            unsigned long total = hits + misses;
+            return total ? double(hits) / total : 0.0;
+        }
+    };
+
+    parse_cache();
+    ~parse_cache();
+
+    parse_cache( const parse_cache & ) = delete;
+    parse_cache & operator=( const parse_cache & ) = delete;
+
+    // The text need not be null-terminated.
+    set parse_set( const context & ctx, const char * text, std::size_t length );
+    map parse_map( const context & ctx, const char * text, std::size_t length );
+    union_set parse_union_set( const context & ctx, const char * text, std::size_t length );
+    union_map parse_union_map( const context & ctx, const char * text, std::size_t length );
+
+    const statistics & stats() const { return m_stats; }
+
+    std::size_t size() const { return m_stats.entries; }
+    void clear();
+
+private:
+    struct tables;
+    std::unique_ptr<tables> d;
+    statistics m_stats;
+};
+
+namespace detail {
+
+template <typename T> struct parser {};
+
+template <> struct parser<set>
+{
+    static set parse( const context & ctx, const char * text, std::size_t length )
+    { return ctx.parsed_texts().parse_set(ctx, text, length); }
+};
+
+template <> struct parser<map>
+{
+    static map parse( const context & ctx, const char * text, std::size_t length )
+    { return ctx.parsed_texts().parse_map(ctx, text, length); }
+};
+
+template <> struct parser<union_set>
+{
+    static union_set parse( const context & ctx, const char * text, std::size_t length )
+    { return ctx.parsed_texts().parse_union_set(ctx, text, length); }
+};
+
+template <> struct parser<union_map>
+{
+    static union_map parse( const context & ctx, const char * text, std::size_t length )
+    { return ctx.parsed_texts().parse_union_map(ctx, text, length); }
+};
+
+}
+
+// Parses a set, map, union_set or union_map through the parse cache
+// of ctx, for example parse<set>(ctx, "{ [i] : 0 <= i < 10 }").
+template <typename T> inline
+T parse( const context & ctx, const char * text )
+{
+    return detail::parser<T>::parse(ctx, text, std::strlen(text));
+}
+
+template <typename T> inline
+T parse( const context & ctx, const std::string & text )
+{
+    return detail::parser<T>::parse(ctx, text.data(), text.size());
+}
+
+// Parses each text through the parse cache of ctx,
+// appending the objects to result in the same order.
+template <typename T> inline
+void parse_all( const context & ctx, const std::vector<const char*> & texts,
+                std::vector<T> & result )
+{
+    result.reserve(result.size() + texts.size());
+    for (const char * text : texts)
+        result.push_back(parse<T>(ctx, text));
+}
+
+template <typename T> inline
+void parse_all( const context & ctx, const std::vector<std::string> & texts,
+                std::vector<T> & result )
+{
+    result.reserve(result.size() + texts.size());
+    for (const std::string & text : texts)
+        result.push_back(parse<T>(ctx, text));
+}
+
+}
+
+#endif // ISL_CPP_PARSE_CACHE_INCLUDED
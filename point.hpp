@@ -25,10 +25,15 @@ along with this program; if not, write to the Free Software Foundation, Inc.,
 #include "object.hpp"
 #include "space.hpp"
 #include "value.hpp"
+#include "integer.hpp"
 #include "printer.hpp"
 
 #include <isl/point.h>
 
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
 namespace isl {
 
 template<>
@@ -58,6 +63,111 @@ public:
         return isl_point_get_coordinate_val
                 ( get(), (isl_dim_type) type, dim );
     }
+
+    int dimension( space::dimension_type type ) const
+    {
+        isl_space * s = isl_point_get_space(get());
+        int n = isl_space_dim(s, (isl_dim_type) type);
+        isl_space_free(s);
+        return n;
+    }
+
+    // Bulk access to coordinates, without an isl::value for each.
+    //
+    // These return false if some coordinate does not fit in 64 bits;
+    // such coordinates are stored as zero.
+
+    // Stores dimension(type) coordinates of the given type into out.
+    bool coordinates( space::dimension_type type, int64_t * out ) const
+    {
+        int n = dimension(type);
+        bool all_fit = true;
+        for (int i = 0; i < n; ++i)
+        {
+            isl_val * v = isl_point_get_coordinate_val(get(), (isl_dim_type) type, i);
+            if (!detail::take_int64(v, out[i]))
+                all_fit = false;
+        }
+        return all_fit;
+    }
+
+    // Stores the set variables, resizing out to their number.
+    bool coordinates( std::vector<int64_t> & out ) const
+    {
+        out.resize(dimension(space::variable));
+        return coordinates(space::variable, out.data());
+    }
+};
+
+// The set variables of a batch of points, stored as a structure of
+// arrays: the values of each variable for all points of the batch
+// are contiguous, so code can vectorize over the batch.
+
+class point_batch
+{
+public:
+    point_batch( int dimension, std::size_t capacity ):
+        m_dimension(dimension),
+        m_capacity(capacity),
+        m_data(std::size_t(dimension) * capacity)
+    {}
+
+    int dimension() const { return m_dimension; }
+    std::size_t size() const { return m_size; }
+    std::size_t capacity() const { return m_capacity; }
+    bool full() const { return m_size == m_capacity; }
+
+    // The values of the given set variable, one for each point.
+    const int64_t * variable( int index ) const
+    {
+        return m_data.data() + index * m_capacity;
+    }
+
+    int64_t at( std::size_t point_index, int variable_index ) const
+    {
+        return variable(variable_index)[point_index];
+    }
+
+    // Appends the set variables of pt.
+    // Throws if the batch is full or some coordinate does not fit
+    // in 64 bits.
+    void push_back( const point & pt )
+    {
+        check_room();
+        int64_t * out = m_data.data() + m_size;
+        for (int i = 0; i < m_dimension; ++i, out += m_capacity)
+        {
+            isl_val * v = isl_point_get_coordinate_val(pt.get(), isl_dim_set, i);
+            if (!detail::take_int64(v, *out))
+                throw error("Point coordinate does not fit in 64 bits.");
+        }
+        ++m_size;
+    }
+
+    // Appends a point with the given dimension() coordinates.
+    // Throws if the batch is full.
+    void push_back( const int64_t * coordinates )
+    {
+        check_room();
+        int64_t * out = m_data.data() + m_size;
+        for (int i = 0; i < m_dimension; ++i, out += m_capacity)
+            *out = coordinates[i];
+        ++m_size;
+    }
+
+    void clear() { m_size = 0; }
+
+private:
+    void check_room() const
+    {
+        if (full())
+            throw error("Point batch is full.");
+    }
+
+    int m_dimension;
+    std::size_t m_capacity;
+    std::size_t m_size = 0;
+    std::vector<int64_t> m_data;
 };
 
 template<> inline
@@ -0,0 +1,202 @@
+/*
+isl-cpp: C++ bindings to the ISL (Integer Set Library)
+
+Copyright (C) 2014  Jakob Leben <jakob.leben@gmail.com>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "point_cursor.hpp"
+
+#include <algorithm>
+
+namespace isl {
+
+namespace {
+
+// Points read ahead for next().
+const std::size_t buffer_size = 256;
+
+int set_dimension( const set & s )
+{
+    if (isl_set_dim(s.get(), isl_dim_param) != 0)
+        throw error("Point cursor needs a set without parameters.");
+    return isl_set_dim(s.get(), isl_dim_set);
+}
+
+// The points of s lexicographically greater than p.
+isl_set * lex_greater( isl_set * s, const std::vector<int64_t> & p )
+{
+    isl_ctx * ctx = isl_set_get_ctx(s);
+    isl_space * space = isl_set_get_space(s);
+    isl_set * greater = isl_set_empty(isl_space_copy(space));
+
+    for (std::size_t k = 0; k < p.size(); ++k)
+    {
+        if (p[k] == INT64_MAX)
+            continue;
+        isl_set * piece = isl_set_universe(isl_space_copy(space));
+        for (std::size_t i = 0; i < k; ++i)
+            piece = isl_set_fix_val(piece, isl_dim_set, i, detail::int64_val(ctx, p[i]));
+        piece = isl_set_lower_bound_val(piece, isl_dim_set, k, detail::int64_val(ctx, p[k] + 1));
+        greater = isl_set_union(greater, piece);
+    }
+
+    isl_space_free(space);
+    return isl_set_intersect(s, greater);
+}
+
+}
+
+point_cursor::point_cursor( const set & s ):
+    m_set(s),
+    m_dimension(set_dimension(s)),
+    m_started(false),
+    m_buffer(m_dimension, buffer_size)
+{}
+
+point_cursor::point_cursor( const set & s, const std::vector<int64_t> & last ):
+    m_set(s),
+    m_dimension(set_dimension(s)),
+    m_last(last),
+    m_frontier(last),
+    m_started(true),
+    m_buffer(m_dimension, buffer_size)
+{
+    if ((int) last.size() != m_dimension)
+        throw error("Resume point has wrong dimension.");
+}
+
+set point_cursor::rest() const
+{
+    if (!m_started)
+        return m_set;
+    return lex_greater(m_set.copy(), m_frontier);
+}
+
+void point_cursor::fill( point_batch & page )
+{
+    if (page.full())
+        return;
+
+    if (m_dimension == 0)
+    {
+        // The only point is the empty tuple.
+        if (!m_started && !m_set.is_empty())
+            page.push_back(m_frontier.data());
+        m_started = true;
+        m_done = true;
+        return;
+    }
+
+    int inner = m_dimension - 1;
+    std::vector<int64_t> row_values;
+
+    while (!page.full() && !m_done)
+    {
+        set remaining = rest();
+        set min = isl_set_lexmin(remaining.release());
+        if (min.is_empty())
+        {
+            m_done = true;
+            break;
+        }
+
+        std::vector<int64_t> first;
+        if (!min.single_point().coordinates(first))
+            throw error("Point coordinate does not fit in 64 bits.");
+
+        // The next points in the innermost row, in a window no wider
+        // than the room left in the page.
+        int64_t width = page.capacity() - page.size();
+        int64_t end = first[inner] > INT64_MAX - width ? INT64_MAX : first[inner] + width - 1;
+
+        isl_ctx * ctx = m_set.ctx().get();
+        isl_set * row = m_set.copy();
+        for (int i = 0; i < inner; ++i)
+            row = isl_set_fix_val(row, isl_dim_set, i, detail::int64_val(ctx, first[i]));
+        row = isl_set_lower_bound_val(row, isl_dim_set, inner, detail::int64_val(ctx, first[inner]));
+        row = isl_set_upper_bound_val(row, isl_dim_set, inner, detail::int64_val(ctx, end));
+
+        row_values.clear();
+        set(row).for_each_point([&](const point & pt){
+            int64_t x;
+            if (!detail::take_int64(isl_point_get_coordinate_val(pt.get(), isl_dim_set, inner), x))
+                throw error("Point coordinate does not fit in 64 bits.");
+            row_values.push_back(x);
+            return true;
+        });
+        std::sort(row_values.begin(), row_values.end());
+
+        m_frontier = first;
+        for (int64_t x : row_values)
+        {
+            if (page.full())
+                break;
+            m_frontier[inner] = x;
+            page.push_back(m_frontier.data());
+        }
+        m_started = true;
+    }
+}
+
+bool point_cursor::next( std::vector<int64_t> & coordinates )
+{
+    if (m_buffer_pos == m_buffer.size())
+    {
+        m_buffer.clear();
+        m_buffer_pos = 0;
+        fill(m_buffer);
+        if (m_buffer.size() == 0)
+            return false;
+    }
+
+    coordinates.resize(m_dimension);
+    for (int i = 0; i < m_dimension; ++i)
+        coordinates[i] = m_buffer.at(m_buffer_pos, i);
+    ++m_buffer_pos;
+    m_last = coordinates;
+    return true;
+}
+
+bool point_cursor::next_page( point_batch & page )
+{
+    if (page.dimension() != m_dimension)
+        throw error("Page has wrong dimension.");
+    if (page.capacity() == 0)
+        throw error("Page has no room for points.");
+
+    page.clear();
+
+    std::vector<int64_t> coordinates(m_dimension);
+    for (; m_buffer_pos < m_buffer.size() && !page.full(); ++m_buffer_pos)
+    {
+        for (int i = 0; i < m_dimension; ++i)
+            coordinates[i] = m_buffer.at(m_buffer_pos, i);
+        page.push_back(coordinates.data());
+    }
+
+    fill(page);
+
+    if (page.size() == 0)
+        return false;
+
+    m_last.resize(m_dimension);
+    for (int i = 0; i < m_dimension; ++i)
+        m_last[i] = page.at(page.size() - 1, i);
+    return true;
+}
+
+}
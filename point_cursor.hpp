@@ -0,0 +1,93 @@
+/*
+isl-cpp: C++ bindings to the ISL (Integer Set Library)
+
+Copyright (C) 2014  Jakob Leben <jakob.leben@gmail.com>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef ISL_CPP_POINT_CURSOR_INCLUDED
+#define ISL_CPP_POINT_CURSOR_INCLUDED
+
+#include "context.hpp"
+#include "set.hpp"
+#include "point.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace isl {
+
+// Walks the integer points of a set in lexicographic order,
+// starting at its lexicographic minimum, one point or one page
+// of points at a time.
+//
+// The last point returned is a resume token: a new cursor over the
+// same set, in any context and on any thread, can continue after it.
+//
+// Each step finds the lexicographic minimum of the rest of the set,
+// and then reads the following points of the same innermost row,
+// so the cost of the minimum is shared by many points.
+//
+// The set must have no parameters and be bounded below
+// lexicographically; it need not be bounded above.
+// Throws if a coordinate does not fit in 64 bits.
+
+class point_cursor
+{
+public:
+    // Starts before the lexicographic minimum of s.
+    explicit point_cursor( const set & s );
+
+    // Continues after the point last.
+    point_cursor( const set & s, const std::vector<int64_t> & last );
+
+    // Stores the next point into coordinates.
+    // Returns false if there are no more points.
+    bool next( std::vector<int64_t> & coordinates );
+
+    // Replaces the contents of page with up to page.capacity()
+    // next points. Returns false if there are no more points.
+    // Throws if the page has no capacity.
+    bool next_page( point_batch & page );
+
+    // The last point returned, or the point resumed after.
+    // Empty before the first point.
+    const std::vector<int64_t> & last() const { return m_last; }
+
+    int dimension() const { return m_dimension; }
+
+private:
+    // Appends the points following m_frontier to page.
+    void fill( point_batch & page );
+    set rest() const;
+
+    set m_set;
+    int m_dimension;
+
+    // The last point returned, and the last point read, which is
+    // further on while points are held in the buffer.
+    std::vector<int64_t> m_last;
+    std::vector<int64_t> m_frontier;
+    bool m_started;
+    bool m_done = false;
+
+    point_batch m_buffer;
+    std::size_t m_buffer_pos = 0;
+};
+
+}
+
+#endif // ISL_CPP_POINT_CURSOR_INCLUDED
@@ -27,6 +27,9 @@ along with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include <memory>
 #include <iostream>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
 
 namespace isl {
 
@@ -49,19 +52,83 @@ public:
       yaml_flow_style = ISL_YAML_STYLE_FLOW
     };
 
+    enum string_target { to_string };
+
+    // Prints to stdout.
     printer(const context & ctx):
         m_ctx(ctx)
     {
         m_printer = isl_printer_to_file(ctx.get(), stdout);
     }
 
+    // Prints to a file owned by the caller.
+    printer(const context & ctx, FILE * file):
+        m_ctx(ctx)
+    {
+        m_printer = isl_printer_to_file(ctx.get(), file);
+    }
+
+    // Prints to a growing string, see str().
+    printer(const context & ctx, string_target):
+        m_ctx(ctx),
+        m_target(string_output)
+    {
+        m_printer = isl_printer_to_str(ctx.get());
+    }
+
+    // Prints to a stream, going through a buffer of about
+    // buffer_size bytes that is written out when full,
+    // and on flush() and destruction.
+    printer(const context & ctx, std::ostream & stream,
+            std::size_t buffer_size = 1 << 20):
+        m_ctx(ctx),
+        m_target(stream_output),
+        m_stream(&stream),
+        m_buffer_size(buffer_size)
+    {
+        m_printer = isl_printer_to_str(ctx.get());
+        m_buffer.reserve(buffer_size);
+    }
+
     printer(const printer & other) = delete;
 
     ~printer()
     {
+        if (m_target == stream_output)
+            flush();
         isl_printer_free(m_printer);
     }
 
+    // Everything printed so far, for a string printer.
+    std::string str() const
+    {
+        if (m_target != string_output)
+            return std::string();
+        char * text = isl_printer_get_str(m_printer);
+        std::string result(text ? text : "");
+        free(text);
+        return result;
+    }
+
+    // Writes out anything buffered, and flushes the file or stream.
+    void flush()
+    {
+        switch (m_target)
+        {
+        case file_output:
+            m_printer = isl_printer_flush(m_printer);
+            break;
+        case string_output:
+            break;
+        case stream_output:
+            take_output();
+            m_stream->write(m_buffer.data(), m_buffer.size());
+            m_buffer.clear();
+            m_stream->flush();
+            break;
+        }
+    }
+
     isl_printer *get() const { return m_printer; }
 
     format current_format() const
@@ -82,12 +149,56 @@ public:
     template <typename T>
     void print( const T & );
 
+    // Prints each element of a set, map or union on its own line.
     template <typename T>
     void print_each_in(const T &);
 
+    // Prints each element of a set, map, union or container
+    // on its own line, and flushes once at the end.
+    template <typename T>
+    void print_all( const T & objects )
+    {
+        for (const auto & object : objects)
+        {
+            print(object);
+            end_line();
+        }
+        flush();
+    }
+
+    void end_line()
+    {
+        m_printer = isl_printer_print_str(m_printer, "\n");
+        if (m_target == stream_output)
+            take_output();
+    }
+
 private:
+    enum target { file_output, string_output, stream_output };
+
+    // Moves text from the isl printer into our buffer,
+    // and the buffer into the stream when it is full.
+    void take_output()
+    {
+        char * text = isl_printer_get_str(m_printer);
+        if (text)
+            m_buffer += text;
+        free(text);
+        m_printer = isl_printer_flush(m_printer);
+
+        if (m_buffer.size() >= m_buffer_size)
+        {
+            m_stream->write(m_buffer.data(), m_buffer.size());
+            m_buffer.clear();
+        }
+    }
+
     isl_printer *m_printer;
     context m_ctx;
+    target m_target = file_output;
+    std::ostream * m_stream = nullptr;
+    std::string m_buffer;
+    std::size_t m_buffer_size = 0;
 };
 
 }
@@ -0,0 +1,213 @@
+/*
+isl-cpp: C++ bindings to the ISL (Integer Set Library)
+
+Copyright (C) 2014  Jakob Leben <jakob.leben@gmail.com>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "reader.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+
+namespace isl {
+
+namespace {
+
+// Read text is released from memory in steps of this size.
+const std::size_t release_step = 64 << 20;
+
+bool is_space( char c )
+{
+    return std::isspace(static_cast<unsigned char>(c));
+}
+
+}
+
+mapped_file::mapped_file( const std::string & path )
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw error("Can not open file: " + path);
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        close(fd);
+        throw error("Can not get size of file: " + path);
+    }
+
+    m_size = info.st_size;
+    if (m_size)
+    {
+        void * data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            close(fd);
+            throw error("Can not map file: " + path);
+        }
+        madvise(data, m_size, MADV_SEQUENTIAL);
+        m_data = static_cast<const char*>(data);
+    }
+
+    close(fd);
+}
+
+mapped_file::~mapped_file()
+{
+    if (m_data)
+        munmap(const_cast<char*>(m_data), m_size);
+}
+
+void mapped_file::release_before( std::size_t offset )
+{
+    std::size_t page = sysconf(_SC_PAGESIZE);
+    offset = std::min(offset, m_size) / page * page;
+    if (offset <= m_released)
+        return;
+    madvise(const_cast<char*>(m_data) + m_released, offset - m_released, MADV_DONTNEED);
+    m_released = offset;
+}
+
+void union_reader::skip_space()
+{
+    while (m_pos < m_size && (is_space(m_text[m_pos]) || m_text[m_pos] == ';'))
+        ++m_pos;
+}
+
+// Reads up to and including the opening brace of the next union.
+bool union_reader::begin_union()
+{
+    skip_space();
+    if (m_pos == m_size)
+        return false;
+
+    std::size_t start = m_pos;
+    int depth = 0;
+    for (; m_pos < m_size; ++m_pos)
+    {
+        char c = m_text[m_pos];
+        if (c == '{' && depth == 0)
+            break;
+        if (c == '(' || c == '[')
+            ++depth;
+        else if (c == ')' || c == ']')
+            --depth;
+        if (depth < 0 || c == '{' || c == '}' || c == ';')
+            throw error("Malformed union text at byte " + std::to_string(m_pos) + ".");
+    }
+    if (m_pos == m_size)
+        throw error("Missing union after byte " + std::to_string(start) + ".");
+
+    m_prefix.assign(m_text + start, m_pos - start);
+    ++m_pos;
+    m_in_union = true;
+    return true;
+}
+
+bool union_reader::next( std::string & element )
+{
+    for (;;)
+    {
+        if (!m_in_union && !begin_union())
+            return false;
+
+        // An element ends at a semicolon or at the closing brace
+        // of the union, outside of any brackets.
+        std::size_t start = m_pos;
+        int depth = 0;
+        for (; m_pos < m_size; ++m_pos)
+        {
+            char c = m_text[m_pos];
+            if (c == '(' || c == '[' || c == '{')
+                ++depth;
+            else if (c == ')' || c == ']' || c == '}')
+            {
+                if (depth == 0)
+                    break;
+                --depth;
+            }
+            else if (c == ';' && depth == 0)
+                break;
+        }
+        if (m_pos == m_size || m_text[m_pos] == ')' || m_text[m_pos] == ']')
+            throw error("Unterminated union element at byte " + std::to_string(start) + ".");
+
+        std::size_t end = m_pos;
+        if (m_text[m_pos] == '}')
+            m_in_union = false;
+        ++m_pos;
+
+        if (m_file && m_pos >= m_file_released + release_step)
+        {
+            m_file->release_before(start);
+            m_file_released = start;
+        }
+
+        bool blank = true;
+        for (std::size_t i = start; i < end && blank; ++i)
+            blank = is_space(m_text[i]);
+        if (blank)
+            continue;
+
+        m_element_start = start;
+        element.reserve(m_prefix.size() + (end - start) + 4);
+        element.assign(m_prefix);
+        element += "{ ";
+        element.append(m_text + start, end - start);
+        element += " }";
+        return true;
+    }
+}
+
+set union_reader::parse_set( const std::string & element )
+{
+    isl_set * s = isl_set_read_from_str(m_ctx.get(), element.c_str());
+    if (!s)
+        throw error("Can not parse set at byte " + std::to_string(m_element_start) + ".");
+    return s;
+}
+
+map union_reader::parse_map( const std::string & element )
+{
+    isl_map * m = isl_map_read_from_str(m_ctx.get(), element.c_str());
+    if (!m)
+        throw error("Can not parse map at byte " + std::to_string(m_element_start) + ".");
+    return m;
+}
+
+void union_reader::read_into( union_set & u )
+{
+    for_each_set([&](set s){
+        u = isl_union_set_add_set(u.release(), s.release());
+        return true;
+    });
+}
+
+void union_reader::read_into( union_map & u )
+{
+    for_each_map([&](map m){
+        u = isl_union_map_add_map(u.release(), m.release());
+        return true;
+    });
+}
+
+}
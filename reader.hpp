@@ -0,0 +1,155 @@
+/*
+isl-cpp: C++ bindings to the ISL (Integer Set Library)
+
+Copyright (C) 2014  Jakob Leben <jakob.leben@gmail.com>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef ISL_CPP_READER_INCLUDED
+#define ISL_CPP_READER_INCLUDED
+
+#include "context.hpp"
+#include "set.hpp"
+#include "map.hpp"
+
+#include <string>
+#include <cstddef>
+#include <cstring>
+
+namespace isl {
+
+// A whole file mapped read-only into memory.
+// Throws if the file can not be opened or mapped.
+
+class mapped_file
+{
+public:
+    explicit mapped_file( const std::string & path );
+    ~mapped_file();
+
+    mapped_file( const mapped_file & ) = delete;
+    mapped_file & operator=( const mapped_file & ) = delete;
+
+    const char * data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+
+    // Lets the system drop the pages before offset from memory.
+    // They are read from the file again if accessed.
+    void release_before( std::size_t offset );
+
+private:
+    const char * m_data = nullptr;
+    std::size_t m_size = 0;
+    std::size_t m_released = 0;
+};
+
+// Reads the text of union sets or union maps one element at a time,
+// for example "[n] -> { A[i] : i < n; B[] }" as "[n] -> { A[i] : i < n }"
+// and "[n] -> { B[] }".
+//
+// The text may hold several unions, optionally separated by semicolons,
+// and all their elements are read in order. Only the text of the current
+// element is copied. Several elements may have the same space.
+//
+// When reading a mapped file, the pages already read are released
+// from memory as reading goes on, so memory use stays bounded
+// however large the file is.
+//
+// Throws if the text is malformed.
+
+class union_reader
+{
+public:
+    // The text must outlive the reader.
+    union_reader( const context & ctx, const char * text, std::size_t size ):
+        m_ctx(ctx), m_text(text), m_size(size)
+    {}
+    union_reader( const context & ctx, const char * text ):
+        union_reader(ctx, text, std::strlen(text))
+    {}
+    union_reader( const context & ctx, const std::string & text ):
+        union_reader(ctx, text.data(), text.size())
+    {}
+    union_reader( const context & ctx, mapped_file & file ):
+        union_reader(ctx, file.data(), file.size())
+    {
+        m_file = &file;
+    }
+
+    // Stores the text of the next element as a complete union.
+    // Returns false when there are no more elements.
+    bool next( std::string & element );
+
+    // Calls f with each element, until f returns false.
+    // Returns false if f did.
+    template <typename F> bool for_each_set( F f );
+    template <typename F> bool for_each_map( F f );
+
+    // Adds all remaining elements to u.
+    void read_into( union_set & u );
+    void read_into( union_map & u );
+
+    // Bytes of text read so far.
+    std::size_t position() const { return m_pos; }
+
+private:
+    set parse_set( const std::string & element );
+    map parse_map( const std::string & element );
+
+    void skip_space();
+    bool begin_union();
+
+    context m_ctx;
+    const char * m_text;
+    std::size_t m_size;
+    std::size_t m_pos = 0;
+    std::size_t m_element_start = 0;
+    mapped_file * m_file = nullptr;
+    std::size_t m_file_released = 0;
+
+    // Text before the opening brace of the current union,
+    // and whether reading is inside its braces.
+    std::string m_prefix;
+    bool m_in_union = false;
+};
+
+template <typename F>
+bool union_reader::for_each_set( F f )
+{
+    std::string element;
+    while (next(element))
+    {
+        if (!f(parse_set(element)))
+            return false;
+    }
+    return true;
+}
+
+template <typename F>
+bool union_reader::for_each_map( F f )
+{
+    std::string element;
+    while (next(element))
+    {
+        if (!f(parse_map(element)))
+            return false;
+    }
+    return true;
+}
+
+}
+
+#endif // ISL_CPP_READER_INCLUDED
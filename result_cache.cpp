@@ -0,0 +1,411 @@
+/*
+isl-cpp: C++ bindings to the ISL (Integer Set Library)
+
+Copyright (C) 2014  Jakob Leben <jakob.leben@gmail.com>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "result_cache.hpp"
+
+#include <iterator>
+#include <list>
+#include <unordered_map>
+
+namespace isl {
+
+struct result_cache::operand::behavior
+{
+    void * (*copy)(void *);
+    void (*destroy)(void *);
+    std::size_t (*hash)(void *);
+    bool (*equal)(void *, void *);
+    // Approximate memory held by the object.
+    std::size_t (*bytes)(void *);
+};
+
+namespace {
+
+// isl stores a constraint as a row of arbitrary precision integers.
+const std::size_t bytes_per_coefficient = 16;
+const std::size_t bytes_per_object = 64;
+
+std::size_t basic_bytes( isl_size n_constraints, isl_size n_dims )
+{
+    std::size_t bytes = bytes_per_object;
+    if (n_constraints > 0 && n_dims >= 0)
+        bytes += n_constraints * (n_dims + 2) * bytes_per_coefficient;
+    return bytes;
+}
+
+isl_stat add_basic_map_bytes( isl_basic_map * bmap, void * user )
+{
+    *static_cast<std::size_t*>(user) +=
+            basic_bytes(isl_basic_map_n_constraint(bmap),
+                        isl_basic_map_dim(bmap, isl_dim_all));
+    isl_basic_map_free(bmap);
+    return isl_stat_ok;
+}
+
+isl_stat add_basic_set_bytes( isl_basic_set * bset, void * user )
+{
+    *static_cast<std::size_t*>(user) +=
+            basic_bytes(isl_basic_set_n_constraint(bset),
+                        isl_basic_set_dim(bset, isl_dim_all));
+    isl_basic_set_free(bset);
+    return isl_stat_ok;
+}
+
+std::size_t set_bytes( isl_set * s )
+{
+    std::size_t bytes = bytes_per_object;
+    isl_set_foreach_basic_set(s, &add_basic_set_bytes, &bytes);
+    return bytes;
+}
+
+std::size_t map_bytes( isl_map * m )
+{
+    std::size_t bytes = bytes_per_object;
+    isl_map_foreach_basic_map(m, &add_basic_map_bytes, &bytes);
+    return bytes;
+}
+
+isl_stat add_map_bytes( isl_map * m, void * user )
+{
+    *static_cast<std::size_t*>(user) += map_bytes(m);
+    isl_map_free(m);
+    return isl_stat_ok;
+}
+
+struct union_map_match
+{
+    isl_union_map * other;
+    bool equal;
+};
+
+isl_stat match_map( isl_map * m, void * user )
+{
+    auto match = static_cast<union_map_match*>(user);
+    isl_map * other = isl_union_map_extract_map(match->other, isl_map_get_space(m));
+    match->equal = isl_map_plain_is_equal(m, other) == isl_bool_true;
+    isl_map_free(other);
+    isl_map_free(m);
+    return match->equal ? isl_stat_ok : isl_stat_error;
+}
+
+const result_cache::operand::behavior set_behavior =
+{
+    [](void * p) -> void * { return isl_set_copy(static_cast<isl_set*>(p)); },
+    [](void * p) { isl_set_free(static_cast<isl_set*>(p)); },
+    [](void * p) -> std::size_t { return isl_set_get_hash(static_cast<isl_set*>(p)); },
+    [](void * a, void * b)
+    {
+        return isl_set_plain_is_equal(static_cast<isl_set*>(a),
+                                      static_cast<isl_set*>(b)) == isl_bool_true;
+    },
+    [](void * p) -> std::size_t { return set_bytes(static_cast<isl_set*>(p)); }
+};
+
+const result_cache::operand::behavior map_behavior =
+{
+    [](void * p) -> void * { return isl_map_copy(static_cast<isl_map*>(p)); },
+    [](void * p) { isl_map_free(static_cast<isl_map*>(p)); },
+    [](void * p) -> std::size_t { return isl_map_get_hash(static_cast<isl_map*>(p)); },
+    [](void * a, void * b)
+    {
+        return isl_map_plain_is_equal(static_cast<isl_map*>(a),
+                                      static_cast<isl_map*>(b)) == isl_bool_true;
+    },
+    [](void * p) -> std::size_t { return map_bytes(static_cast<isl_map*>(p)); }
+};
+
+const result_cache::operand::behavior union_map_behavior =
+{
+    [](void * p) -> void * { return isl_union_map_copy(static_cast<isl_union_map*>(p)); },
+    [](void * p) { isl_union_map_free(static_cast<isl_union_map*>(p)); },
+    [](void * p) -> std::size_t { return isl_union_map_get_hash(static_cast<isl_union_map*>(p)); },
+    [](void * a, void * b)
+    {
+        // Compare the maps in each space, which is cheap
+        // compared to isl_union_map_is_equal.
+        auto ua = static_cast<isl_union_map*>(a);
+        auto ub = static_cast<isl_union_map*>(b);
+        isl_size n = isl_union_map_n_map(ua);
+        if (n < 0 || n != isl_union_map_n_map(ub))
+            return false;
+        union_map_match match = { ub, true };
+        isl_union_map_foreach_map(ua, &match_map, &match);
+        return match.equal;
+    },
+    [](void * p) -> std::size_t
+    {
+        std::size_t bytes = bytes_per_object;
+        isl_union_map_foreach_map(static_cast<isl_union_map*>(p), &add_map_bytes, &bytes);
+        return bytes;
+    }
+};
+
+const result_cache::operand::behavior aff_behavior =
+{
+    [](void * p) -> void * { return isl_aff_copy(static_cast<isl_aff*>(p)); },
+    [](void * p) { isl_aff_free(static_cast<isl_aff*>(p)); },
+    [](void * p) -> std::size_t { return isl_aff_get_hash(static_cast<isl_aff*>(p)); },
+    [](void * a, void * b)
+    {
+        return isl_aff_plain_is_equal(static_cast<isl_aff*>(a),
+                                      static_cast<isl_aff*>(b)) == isl_bool_true;
+    },
+    [](void * p) -> std::size_t
+    {
+        auto aff = static_cast<isl_aff*>(p);
+        isl_size n_dims = isl_aff_dim(aff, isl_dim_in) + isl_aff_dim(aff, isl_dim_param)
+                + isl_aff_dim(aff, isl_dim_div);
+        return bytes_per_object + (n_dims + 2) * bytes_per_coefficient;
+    }
+};
+
+const result_cache::operand::behavior val_behavior =
+{
+    [](void * p) -> void * { return isl_val_copy(static_cast<isl_val*>(p)); },
+    [](void * p) { isl_val_free(static_cast<isl_val*>(p)); },
+    [](void * p) -> std::size_t { return isl_val_get_hash(static_cast<isl_val*>(p)); },
+    [](void * a, void * b)
+    {
+        return isl_val_eq(static_cast<isl_val*>(a),
+                          static_cast<isl_val*>(b)) == isl_bool_true;
+    },
+    [](void *) -> std::size_t { return bytes_per_object; }
+};
+
+}
+
+result_cache::operand::operand( isl_set * s ): object(s), type(&set_behavior) {}
+result_cache::operand::operand( isl_map * m ): object(m), type(&map_behavior) {}
+result_cache::operand::operand( isl_union_map * m ): object(m), type(&union_map_behavior) {}
+result_cache::operand::operand( isl_aff * a ): object(a), type(&aff_behavior) {}
+result_cache::operand::operand( isl_val * v ): object(v), type(&val_behavior) {}
+
+namespace {
+
+result_cache::operand copy_of( result_cache::operand o )
+{
+    if (o.object)
+        o.object = o.type->copy(o.object);
+    return o;
+}
+
+void destroy( result_cache::operand & o )
+{
+    if (o.object)
+        o.type->destroy(o.object);
+    o = result_cache::operand();
+}
+
+bool equal( const result_cache::operand & a, const result_cache::operand & b )
+{
+    if (a.type != b.type)
+        return false;
+    if (a.object == b.object)
+        return true;
+    if (!a.object || !b.object)
+        return false;
+    return a.type->equal(a.object, b.object);
+}
+
+std::size_t hash_of( const result_cache::operand & o )
+{
+    return o.object ? o.type->hash(o.object) : 0;
+}
+
+std::size_t bytes_of( const result_cache::operand & o )
+{
+    return o.object ? o.type->bytes(o.object) : 0;
+}
+
+}
+
+result_cache::key::key( query q, operand a, operand b ):
+    m_query(q),
+    m_a(copy_of(a)),
+    m_b(copy_of(b))
+{
+    m_hash = q;
+    m_hash = m_hash * 31 + hash_of(m_a);
+    m_hash = m_hash * 31 + hash_of(m_b);
+}
+
+result_cache::key::key( key && other ):
+    m_query(other.m_query),
+    m_hash(other.m_hash),
+    m_a(other.m_a),
+    m_b(other.m_b)
+{
+    other.m_a = operand();
+    other.m_b = operand();
+}
+
+result_cache::key::~key()
+{
+    destroy(m_a);
+    destroy(m_b);
+}
+
+struct result_cache::entry
+{
+    entry( key && k ): k(std::move(k)) {}
+
+    entry( entry && other ):
+        k(std::move(other.k)),
+        answer(other.answer),
+        result(other.result),
+        bytes(other.bytes)
+    {
+        other.result = operand();
+    }
+
+    ~entry() { destroy(result); }
+
+    key k;
+    bool answer = false;
+    operand result;
+    std::size_t bytes = 0;
+};
+
+struct result_cache::index
+{
+    typedef std::list<entry>::iterator position;
+
+    // Most recently used first.
+    std::list<entry> entries;
+    std::unordered_multimap<std::size_t, position> by_hash;
+};
+
+std::atomic<int> result_cache::s_count(0);
+
+result_cache::result_cache( std::size_t max_bytes ):
+    m_max_bytes(max_bytes),
+    m_index(new index)
+{
+    ++s_count;
+}
+
+result_cache::~result_cache()
+{
+    --s_count;
+}
+
+void result_cache::set_max_bytes( std::size_t max_bytes )
+{
+    m_max_bytes = max_bytes;
+    evict();
+}
+
+void result_cache::clear()
+{
+    m_index->by_hash.clear();
+    m_index->entries.clear();
+    m_stats.entries = 0;
+    m_stats.bytes = 0;
+}
+
+result_cache::entry * result_cache::lookup( const key & k )
+{
+    auto range = m_index->by_hash.equal_range(k.m_hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        const key & other = it->second->k;
+        if (other.m_query == k.m_query && equal(other.m_a, k.m_a) && equal(other.m_b, k.m_b))
+        {
+            auto & entries = m_index->entries;
+            entries.splice(entries.begin(), entries, it->second);
+            ++m_stats.hits;
+            return &entries.front();
+        }
+    }
+    ++m_stats.misses;
+    return nullptr;
+}
+
+bool result_cache::find_answer( const key & k, bool & answer )
+{
+    entry * e = lookup(k);
+    if (!e)
+        return false;
+    answer = e->answer;
+    return true;
+}
+
+void * result_cache::find_object( const key & k )
+{
+    entry * e = lookup(k);
+    if (!e)
+        return nullptr;
+    return copy_of(e->result).object;
+}
+
+void result_cache::insert_answer( key && k, bool answer )
+{
+    entry e(std::move(k));
+    e.answer = answer;
+    e.bytes = bytes_of(e.k.m_a) + bytes_of(e.k.m_b);
+    add(std::move(e));
+}
+
+void result_cache::insert_result( key && k, operand result )
+{
+    entry e(std::move(k));
+    e.result = copy_of(result);
+    e.bytes = bytes_of(e.k.m_a) + bytes_of(e.k.m_b) + bytes_of(e.result);
+    add(std::move(e));
+}
+
+void result_cache::add( entry && e )
+{
+    std::size_t hash = e.k.m_hash;
+    m_stats.bytes += e.bytes;
+    ++m_stats.entries;
+
+    auto & entries = m_index->entries;
+    entries.push_front(std::move(e));
+    m_index->by_hash.emplace(hash, entries.begin());
+
+    evict();
+}
+
+void result_cache::evict()
+{
+    auto & entries = m_index->entries;
+    while (m_stats.bytes > m_max_bytes && !entries.empty())
+    {
+        auto last = std::prev(entries.end());
+
+        auto range = m_index->by_hash.equal_range(last->k.m_hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second == last)
+            {
+                m_index->by_hash.erase(it);
+                break;
+            }
+        }
+
+        m_stats.bytes -= last->bytes;
+        --m_stats.entries;
+        ++m_stats.evictions;
+        entries.erase(last);
+    }
+}
+
+}
@@ -0,0 +1,225 @@
+/*
+isl-cpp: C++ bindings to the ISL (Integer Set Library)
+
+Copyright (C) 2014  Jakob Leben <jakob.leben@gmail.com>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef ISL_CPP_RESULT_CACHE_INCLUDED
+#define ISL_CPP_RESULT_CACHE_INCLUDED
+
+#include "context.hpp"
+#include "object.hpp"
+
+#include <isl/set.h>
+#include <isl/map.h>
+#include <isl/union_map.h>
+#include <isl/aff.h>
+#include <isl/val.h>
+
+#include <cstddef>
+#include <memory>
+#include <atomic>
+
+namespace isl {
+
+// Remembers the results of expensive queries in one context.
+// Results are found by a structural hash of the operands, and operands
+// with equal hashes are compared structurally before a result is reused.
+//
+// The cache is bounded by an approximate size of the objects it holds.
+// When full, the least recently used results are evicted.
+//
+// Enable it with context::enable_result_cache(). The set, map and
+// union_map queries then go through it transparently.
+
+class result_cache
+{
+public:
+    enum query
+    {
+        is_empty_query,
+        is_subset_query,
+        lex_minimum_query,
+        lex_maximum_query,
+        minimum_query,
+        maximum_query,
+        coalesce_query
+    };
+
+    struct statistics
+    {
+        unsigned long hits = 0;
+        unsigned long misses = 0;
+        unsigned long evictions = 0;
+        std::size_t entries = 0;
+        std::size_t bytes = 0;
+    };
+
+    // A borrowed isl object of any type the cache understands.
+    struct operand
+    {
+        struct behavior;
+
+        operand(): object(nullptr), type(nullptr) {}
+        operand( isl_set * );
+        operand( isl_map * );
+        operand( isl_union_map * );
+        operand( isl_aff * );
+        operand( isl_val * );
+
+        void * object;
+        const behavior * type;
+    };
+
+    // Owns references to the operands of a query, and their hash.
+    class key
+    {
+    public:
+        key( query q, operand a, operand b );
+        key( key && other );
+        ~key();
+
+        key( const key & ) = delete;
+        key & operator=( const key & ) = delete;
+
+    private:
+        friend class result_cache;
+        query m_query;
+        std::size_t m_hash;
+        operand m_a;
+        operand m_b;
+    };
+
+    explicit result_cache( std::size_t max_bytes );
+    ~result_cache();
+
+    result_cache( const result_cache & ) = delete;
+    result_cache & operator=( const result_cache & ) = delete;
+
+    std::size_t max_bytes() const { return m_max_bytes; }
+    void set_max_bytes( std::size_t max_bytes );
+
+    const statistics & stats() const { return m_stats; }
+
+    void clear();
+
+    bool find_answer( const key & k, bool & answer );
+    void insert_answer( key && k, bool answer );
+
+    // Returns a new reference to the cached result, or null.
+    template <typename R>
+    R * find_result( const key & k )
+    {
+        return static_cast<R*>(find_object(k));
+    }
+
+    // Keeps a reference to the result.
+    void insert_result( key && k, operand result );
+
+    // Whether any context has a result cache, so queries in
+    // other contexts can skip looking for one.
+    static bool in_use() { return s_count.load(std::memory_order_relaxed) > 0; }
+
+private:
+    struct entry;
+    struct index;
+
+    void * find_object( const key & k );
+    entry * lookup( const key & k );
+    void add( entry && e );
+    void evict();
+
+    std::size_t m_max_bytes;
+    statistics m_stats;
+    std::unique_ptr<index> m_index;
+
+    static std::atomic<int> s_count;
+};
+
+// Answers a yes/no query about obj through the result cache of its
+// context, if there is one.
+template <typename T, typename F>
+bool cached_answer( const object<T> & obj, result_cache::query q,
+                    result_cache::operand other, F compute )
+{
+    result_cache * cache = nullptr;
+    if (result_cache::in_use() && obj.is_valid())
+        cache = obj.ctx().cache();
+    if (!cache)
+        return checked(compute());
+
+    result_cache::key k(q, obj.get(), other);
+    bool answer;
+    if (cache->find_answer(k, answer))
+        return answer;
+
+    isl_bool result = checked(compute());
+    if (result != isl_bool_error)
+        cache->insert_answer(std::move(k), result == isl_bool_true);
+    return result;
+}
+
+// Computes an object from obj through the result cache of its
+// context, if there is one. The key is taken before computing,
+// so compute may release obj.
+template <typename R, typename T, typename F>
+R * cached_result( const object<T> & obj, result_cache::query q,
+                   result_cache::operand other, F compute )
+{
+    result_cache * cache = nullptr;
+    if (result_cache::in_use() && obj.is_valid())
+        cache = obj.ctx().cache();
+    if (!cache)
+        return compute();
+
+    result_cache::key k(q, obj.get(), other);
+    if (R * result = cache->find_result<R>(k))
+        return result;
+
+    R * result = compute();
+    if (result)
+        cache->insert_result(std::move(k), result);
+    return result;
+}
+
+// Like cached_result, for idempotent operations that modify obj in
+// place. The key on obj is dropped before computing, so isl need not
+// copy obj, and the result is remembered as the result of itself.
+template <typename R, typename T, typename F>
+R * cached_in_place_result( const object<T> & obj, result_cache::query q, F compute )
+{
+    result_cache * cache = nullptr;
+    if (result_cache::in_use() && obj.is_valid())
+        cache = obj.ctx().cache();
+    if (!cache)
+        return compute();
+
+    {
+        result_cache::key k(q, obj.get(), {});
+        if (R * result = cache->find_result<R>(k))
+            return result;
+    }
+
+    R * result = compute();
+    if (result)
+        cache->insert_result(result_cache::key(q, result, {}), result);
+    return result;
+}
+
+}
+
+#endif // ISL_CPP_RESULT_CACHE_INCLUDED
@@ -83,7 +83,7 @@ public:
     }
     schedule & intersect_domain(const union_set & domain)
     {
-        m_object = isl_schedule_intersect_domain(m_object, domain.copy());
+        update(isl_schedule_intersect_domain(m_object, domain.copy()));
         return *this;
     }
 };
@@ -110,17 +110,17 @@ public:
 
     void to_child(int pos)
     {
-        m_object = isl_schedule_node_child(m_object, pos);
+        update(isl_schedule_node_child(m_object, pos));
     }
 
     void to_parent()
     {
-        m_object = isl_schedule_node_parent(m_object);
+        update(isl_schedule_node_parent(m_object));
     }
 
     void remove()
     {
-        m_object = isl_schedule_node_delete(m_object);
+        update(isl_schedule_node_delete(m_object));
     }
 };
 
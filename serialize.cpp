@@ -0,0 +1,802 @@
+/*
+isl-cpp: C++ bindings to the ISL (Integer Set Library)
+
+Copyright (C) 2014  Jakob Leben <jakob.leben@gmail.com>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "serialize.hpp"
+#include "matrix.hpp"
+
+#include <isl/local_space.h>
+#include <isl/aff.h>
+
+#include <algorithm>
+#include <cstring>
+#include <climits>
+#include <cstdlib>
+#include <cstdint>
+
+namespace isl {
+
+namespace {
+
+// "ISLCPPB" followed by a zero byte, as a little endian word.
+const uint64_t magic = 0x00425050434c5349ull;
+const uint64_t version = 2;
+
+enum object_kind : uint64_t
+{
+    basic_set_kind = 1,
+    set_kind,
+    union_set_kind,
+    basic_map_kind,
+    map_kind,
+    union_map_kind
+};
+
+enum matrix_encoding : uint64_t
+{
+    // Elements of 8, 16 or 32 bits packed into words,
+    // the first in the lowest bits.
+    int8_encoding,
+    int16_encoding,
+    int32_encoding,
+    int64_encoding,
+    limb_encoding
+};
+
+enum tuple_kind : uint64_t
+{
+    flat_tuple,
+    wrapped_tuple,
+    // The space of a parameter set.
+    no_tuple
+};
+
+const uint32_t no_name = ~uint32_t(0);
+
+uint64_t to_little_endian( uint64_t x )
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap64(x);
+#else
+    return x;
+#endif
+}
+
+uint32_t to_little_endian( uint32_t x )
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap32(x);
+#else
+    return x;
+#endif
+}
+
+// Two 32-bit fields in one word, the first in the low half.
+uint64_t pair( uint64_t low, uint64_t high )
+{
+    return low | high << 32;
+}
+
+// Throws if isl could not give a dimension count.
+isl_size checked_size( isl_size n )
+{
+    if (n < 0)
+    {
+        context::budget_scope::check();
+        throw error("Can not serialize object.");
+    }
+    return n;
+}
+
+class writer
+{
+public:
+    writer( std::vector<char> & buffer ): m_buffer(buffer) {}
+
+    void word( uint64_t x )
+    {
+        x = to_little_endian(x);
+        const char * bytes = reinterpret_cast<const char*>(&x);
+        m_buffer.insert(m_buffer.end(), bytes, bytes + sizeof(x));
+    }
+
+    void words( const uint64_t * data, std::size_t count )
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            word(data[i]);
+    }
+
+    // A name is its 32-bit length and its bytes,
+    // padded to a whole word.
+    void name( const char * text )
+    {
+        std::size_t length = text ? strlen(text) : 0;
+        if (length >= no_name)
+            throw error("Name is too long to serialize.");
+        uint32_t prefix = to_little_endian(text ? uint32_t(length) : no_name);
+        const char * bytes = reinterpret_cast<const char*>(&prefix);
+        m_buffer.insert(m_buffer.end(), bytes, bytes + sizeof(prefix));
+        m_buffer.insert(m_buffer.end(), text, text + length);
+        m_buffer.insert(m_buffer.end(), padding(length), 0);
+    }
+
+    // Padding after a name of the given length.
+    static std::size_t padding( std::size_t length )
+    {
+        return (8 - (sizeof(uint32_t) + length) % 8) % 8;
+    }
+
+private:
+    std::vector<char> & m_buffer;
+};
+
+class reader
+{
+public:
+    reader( byte_span data ): m_data(data), m_pos(0) {}
+
+    uint64_t word()
+    {
+        require(sizeof(uint64_t));
+        uint64_t x;
+        memcpy(&x, m_data.data + m_pos, sizeof(x));
+        m_pos += sizeof(x);
+        return to_little_endian(x);
+    }
+
+    // Reads a count that must be followed by at least
+    // count * min_words words.
+    std::size_t count( std::size_t min_words = 0 )
+    {
+        uint64_t n = word();
+        if (min_words && n > (m_data.size - m_pos) / (min_words * sizeof(uint64_t)))
+            throw error("Truncated binary data.");
+        return n;
+    }
+
+    void words( uint64_t * out, std::size_t count )
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            out[i] = word();
+    }
+
+    void require_words( std::size_t n )
+    {
+        if (n > (m_data.size - m_pos) / sizeof(uint64_t))
+            throw error("Truncated binary data.");
+    }
+
+    // Returns false if there is no name.
+    bool name( std::string & text )
+    {
+        require(sizeof(uint32_t));
+        uint32_t length;
+        memcpy(&length, m_data.data + m_pos, sizeof(length));
+        length = to_little_endian(length);
+        m_pos += sizeof(length);
+        if (length == no_name)
+        {
+            require(writer::padding(0));
+            m_pos += writer::padding(0);
+            return false;
+        }
+        if (length > m_data.size - m_pos)
+            throw error("Truncated binary data.");
+        require(length + writer::padding(length));
+        text.assign(m_data.data + m_pos, length);
+        m_pos += length + writer::padding(length);
+        return true;
+    }
+
+private:
+    void require( std::size_t n )
+    {
+        if (n > m_data.size - m_pos)
+            throw error("Truncated binary data.");
+    }
+
+    byte_span m_data;
+    std::size_t m_pos;
+};
+
+// Spaces
+
+void write_tuple( writer & w, isl_space * s );
+
+// Writes the names of the parameters of s.
+void write_params( writer & w, isl_space * s )
+{
+    isl_size n = checked_size(isl_space_dim(s, isl_dim_param));
+    w.word(n);
+    for (isl_size i = 0; i < n; ++i)
+        w.name(isl_space_get_dim_name(s, isl_dim_param, i));
+}
+
+// Writes the tuple of set space s, which may wrap a map space.
+// Takes s.
+void write_tuple( writer & w, isl_space * s )
+{
+    if (isl_space_is_params(s) == isl_bool_true)
+    {
+        w.name(nullptr);
+        w.word(no_tuple);
+        isl_space_free(s);
+        return;
+    }
+
+    w.name(isl_space_get_tuple_name(s, isl_dim_set));
+
+    if (isl_space_is_wrapping(s) == isl_bool_true)
+    {
+        w.word(wrapped_tuple);
+        isl_space * m = isl_space_unwrap(s);
+        write_tuple(w, isl_space_domain(isl_space_copy(m)));
+        write_tuple(w, isl_space_range(m));
+        return;
+    }
+
+    // The kind of a flat tuple is followed by its size in the same word.
+    isl_size n = isl_space_dim(s, isl_dim_set);
+    if (n < 0)
+    {
+        isl_space_free(s);
+        checked_size(n);
+    }
+    w.word(pair(flat_tuple, n));
+    for (isl_size i = 0; i < n; ++i)
+        w.name(isl_space_get_dim_name(s, isl_dim_set, i));
+    isl_space_free(s);
+}
+
+void write_space( writer & w, isl_space * s )
+{
+    write_params(w, s);
+    write_tuple(w, isl_space_copy(s));
+}
+
+// Objects being read are held by wrappers, so that nothing leaks
+// when reading throws.
+
+space read_params( reader & r, const context & ctx )
+{
+    std::size_t n = r.count(1);
+    space s(isl_space_params_alloc(ctx.get(), n));
+    std::string text;
+    for (std::size_t i = 0; i < n; ++i)
+        if (r.name(text))
+            s = isl_space_set_dim_name(s.release(), isl_dim_param, i, text.c_str());
+    return s;
+}
+
+space read_tuple( reader & r, const space & params, bool allow_params = false );
+
+space read_wrapped_tuple( reader & r, const space & params )
+{
+    space domain = read_tuple(r, params);
+    space range = read_tuple(r, params);
+    return isl_space_wrap(isl_space_map_from_domain_and_range(domain.release(), range.release()));
+}
+
+space read_flat_tuple( reader & r, const space & params, std::size_t n )
+{
+    r.require_words(n);
+    space s(isl_space_add_dims(isl_space_set_from_params(params.copy()), isl_dim_set, n));
+    std::string text;
+    for (std::size_t i = 0; i < n; ++i)
+        if (r.name(text))
+            s = isl_space_set_dim_name(s.release(), isl_dim_set, i, text.c_str());
+    return s;
+}
+
+// Builds a set space with the parameters of params,
+// or the parameter space itself if this is allowed.
+space read_tuple( reader & r, const space & params, bool allow_params )
+{
+    std::string tuple_name;
+    bool has_name = r.name(tuple_name);
+
+    uint64_t kind = r.word();
+    std::size_t n = kind >> 32;
+    kind &= 0xffffffff;
+    if (kind == no_tuple && n == 0 && allow_params && !has_name)
+        return params;
+    if (kind == wrapped_tuple && n != 0)
+        throw error("Invalid binary data.");
+    if (kind != flat_tuple && kind != wrapped_tuple)
+        throw error("Invalid binary data.");
+
+    space s = kind == wrapped_tuple ? read_wrapped_tuple(r, params) : read_flat_tuple(r, params, n);
+    if (has_name)
+        s = isl_space_set_tuple_name(s.release(), isl_dim_set, tuple_name.c_str());
+    return s;
+}
+
+space read_space( reader & r, const context & ctx )
+{
+    space params = read_params(r, ctx);
+    return read_tuple(r, params, true);
+}
+
+// Matrices
+
+// Number of bits of elements with the given encoding, up to 64.
+int element_bits( uint64_t encoding )
+{
+    return 8 << encoding;
+}
+
+// The encoding with the fewest bits that holds every element of data.
+matrix_encoding packed_encoding( const std::vector<int64_t> & data )
+{
+    int64_t low = 0, high = 0;
+    for (int64_t x : data)
+    {
+        low = std::min(low, x);
+        high = std::max(high, x);
+    }
+    if (low >= INT8_MIN && high <= INT8_MAX)
+        return int8_encoding;
+    if (low >= INT16_MIN && high <= INT16_MAX)
+        return int16_encoding;
+    if (low >= INT32_MIN && high <= INT32_MAX)
+        return int32_encoding;
+    return int64_encoding;
+}
+
+void write_packed( writer & w, const int64_t * data, std::size_t n, int bits )
+{
+    std::size_t per_word = 64 / bits;
+    uint64_t mask = bits < 64 ? (uint64_t(1) << bits) - 1 : ~uint64_t(0);
+    for (std::size_t i = 0; i < n; i += per_word)
+    {
+        uint64_t x = 0;
+        for (std::size_t k = 0; k < per_word && i + k < n; ++k)
+            x |= (uint64_t(data[i+k]) & mask) << (k * bits);
+        w.word(x);
+    }
+}
+
+void read_packed( reader & r, int64_t * data, std::size_t n, int bits )
+{
+    std::size_t per_word = 64 / bits;
+    r.require_words((n + per_word - 1) / per_word);
+    if (bits == 64)
+    {
+        r.words(reinterpret_cast<uint64_t*>(data), n);
+        return;
+    }
+    uint64_t mask = (uint64_t(1) << bits) - 1;
+    int64_t sign = int64_t(1) << (bits - 1);
+    for (std::size_t i = 0; i < n; i += per_word)
+    {
+        uint64_t x = r.word();
+        for (std::size_t k = 0; k < per_word && i + k < n; ++k)
+        {
+            int64_t e = int64_t((x >> (k * bits)) & mask);
+            data[i+k] = (e ^ sign) - sign;
+        }
+    }
+}
+
+// A matrix is its row count and encoding in one word, followed by its
+// elements. The column count is known to the reader.
+void write_matrix( writer & w, const matrix & m )
+{
+    std::vector<int64_t> data;
+    if (m.to_int64(data))
+    {
+        matrix_encoding encoding = packed_encoding(data);
+        w.word(pair(m.row_count(), encoding));
+        write_packed(w, data.data(), data.size(), element_bits(encoding));
+        return;
+    }
+
+    matrix::integer_buffer big;
+    m.to_integers(big);
+    w.word(pair(m.row_count(), limb_encoding));
+    std::vector<int64_t> sizes(big.sizes.begin(), big.sizes.end());
+    write_packed(w, sizes.data(), sizes.size(), element_bits(int32_encoding));
+    w.word(big.limbs.size());
+    w.words(big.limbs.data(), big.limbs.size());
+}
+
+matrix read_matrix( reader & r, const context & ctx, std::size_t cols )
+{
+    uint64_t header = r.word();
+    std::size_t rows = header & 0xffffffff;
+    uint64_t encoding = header >> 32;
+    if (rows > INT_MAX || cols > INT_MAX || (cols && rows > INT_MAX / cols))
+        throw error("Invalid binary data.");
+    std::size_t n = rows * cols;
+
+    if (encoding <= int64_encoding)
+    {
+        std::vector<int64_t> data(n);
+        read_packed(r, data.data(), n, element_bits(encoding));
+        return matrix::from_int64(ctx, rows, cols, data.data());
+    }
+    if (encoding == limb_encoding)
+    {
+        std::vector<int64_t> sizes(n);
+        read_packed(r, sizes.data(), n, element_bits(int32_encoding));
+        matrix::integer_buffer big;
+        big.sizes.assign(sizes.begin(), sizes.end());
+        big.limbs.resize(r.count(1));
+        r.words(big.limbs.data(), big.limbs.size());
+
+        std::size_t n_limbs = 0;
+        for (int size : big.sizes)
+        {
+            if (size < -INT_MAX)
+                throw error("Invalid binary data.");
+            n_limbs += std::abs(size);
+            if (n_limbs > big.limbs.size())
+                throw error("Invalid binary data.");
+        }
+        if (n_limbs != big.limbs.size())
+            throw error("Invalid binary data.");
+        return matrix::from_integers(ctx, rows, cols, big);
+    }
+    throw error("Invalid binary data.");
+}
+
+// Basic sets
+
+// Each row holds the denominator of a division followed by its
+// numerator, with the same columns as the constraint matrices.
+// Unknown divisions have a zero row.
+matrix division_matrix( isl_basic_set * bset )
+{
+    isl_ctx * ctx = isl_basic_set_get_ctx(bset);
+    isl_size n_param = checked_size(isl_basic_set_dim(bset, isl_dim_param));
+    isl_size n_set = checked_size(isl_basic_set_dim(bset, isl_dim_set));
+    isl_size n_div = checked_size(isl_basic_set_dim(bset, isl_dim_div));
+
+    isl_mat * m = isl_mat_alloc(ctx, n_div, 2 + n_param + n_set + n_div);
+    isl_local_space * ls = isl_basic_set_get_local_space(bset);
+
+    for (isl_size i = 0; i < n_div; ++i)
+    {
+        isl_aff * div = isl_local_space_get_div(ls, i);
+        if (isl_aff_is_nan(div) == isl_bool_true)
+        {
+            for (int c = 0; c < 2 + n_param + n_set + n_div; ++c)
+                m = isl_mat_set_element_si(m, i, c, 0);
+            isl_aff_free(div);
+            continue;
+        }
+
+        // Coefficients are rational, with the denominator of the division.
+        isl_val * d = isl_aff_get_denominator_val(div);
+        auto scaled = [&](isl_val * c){
+            return isl_val_mul(c, isl_val_copy(d));
+        };
+
+        int col = 0;
+        auto set = [&](isl_val * v){
+            m = isl_mat_set_element_val(m, i, col++, v);
+        };
+
+        set(isl_val_copy(d));
+        set(scaled(isl_aff_get_constant_val(div)));
+        for (isl_size j = 0; j < n_param; ++j)
+            set(scaled(isl_aff_get_coefficient_val(div, isl_dim_param, j)));
+        for (isl_size j = 0; j < n_set; ++j)
+            set(scaled(isl_aff_get_coefficient_val(div, isl_dim_in, j)));
+        for (isl_size j = 0; j < n_div; ++j)
+            set(scaled(isl_aff_get_coefficient_val(div, isl_dim_div, j)));
+
+        isl_val_free(d);
+        isl_aff_free(div);
+    }
+
+    isl_local_space_free(ls);
+    return matrix(m);
+}
+
+// The division matrix is left out when there are no divisions.
+void write_basic_set_body( writer & w, isl_basic_set * bset )
+{
+    isl_size n_div = checked_size(isl_basic_set_dim(bset, isl_dim_div));
+    w.word(n_div);
+    write_matrix(w, isl_basic_set_equalities_matrix
+                 (bset, isl_dim_cst, isl_dim_param, isl_dim_set, isl_dim_div));
+    write_matrix(w, isl_basic_set_inequalities_matrix
+                 (bset, isl_dim_cst, isl_dim_param, isl_dim_set, isl_dim_div));
+    if (n_div > 0)
+        write_matrix(w, division_matrix(bset));
+}
+
+// The constraints m * d <= f <= m * d + m - 1
+// that define each known division d = floor(f / m).
+isl_mat * division_constraints( const matrix & divs, int first_div_col )
+{
+    isl_mat * d = divs.get();
+    int n_div = divs.row_count();
+    int n_col = divs.column_count() - 1;
+
+    int n_known = 0;
+    for (int i = 0; i < n_div; ++i)
+    {
+        isl_val * m = isl_mat_get_element_val(d, i, 0);
+        if (isl_val_is_zero(m) != isl_bool_true)
+            ++n_known;
+        isl_val_free(m);
+    }
+
+    isl_mat * c = isl_mat_alloc(isl_mat_get_ctx(d), 2 * n_known, n_col);
+    int row = 0;
+    for (int i = 0; i < n_div; ++i)
+    {
+        isl_val * m = isl_mat_get_element_val(d, i, 0);
+        if (isl_val_is_zero(m) == isl_bool_true)
+        {
+            isl_val_free(m);
+            continue;
+        }
+
+        for (int col = 0; col < n_col; ++col)
+        {
+            isl_val * f = isl_mat_get_element_val(d, i, col + 1);
+            c = isl_mat_set_element_val(c, row + 1, col, isl_val_neg(isl_val_copy(f)));
+            c = isl_mat_set_element_val(c, row, col, f);
+        }
+
+        // f - m * d >= 0
+        int div_col = first_div_col + i;
+        isl_val * x = isl_mat_get_element_val(c, row, div_col);
+        c = isl_mat_set_element_val(c, row, div_col, isl_val_sub(x, isl_val_copy(m)));
+
+        // -f + m * d + m - 1 >= 0
+        x = isl_mat_get_element_val(c, row + 1, div_col);
+        c = isl_mat_set_element_val(c, row + 1, div_col, isl_val_add(x, isl_val_copy(m)));
+        x = isl_mat_get_element_val(c, row + 1, 0);
+        x = isl_val_add(x, isl_val_sub_ui(m, 1));
+        c = isl_mat_set_element_val(c, row + 1, 0, x);
+
+        row += 2;
+    }
+
+    return c;
+}
+
+basic_set read_basic_set_body( reader & r, const context & ctx, const space & spc )
+{
+    std::size_t n_div = r.count();
+    if (n_div > INT_MAX / 2)
+        throw error("Invalid binary data.");
+    std::size_t n_col = 1 + isl_space_dim(spc.get(), isl_dim_all) + n_div;
+
+    matrix eq = read_matrix(r, ctx, n_col);
+    matrix ineq = read_matrix(r, ctx, n_col);
+    matrix divs = n_div > 0 ? read_matrix(r, ctx, n_col + 1)
+                            : matrix(isl_mat_alloc(ctx.get(), 0, n_col + 1));
+    if (divs.row_count() != (int) n_div)
+        throw error("Invalid binary data.");
+
+    // Divisions become existential variables, with constraints
+    // that give known divisions their values.
+    int first_div_col = n_col - n_div;
+    isl_mat * all_ineq = isl_mat_concat(ineq.release(),
+                                        division_constraints(divs, first_div_col));
+
+    return isl_basic_set_from_constraint_matrices
+            (spc.copy(), eq.release(), all_ineq,
+             isl_dim_cst, isl_dim_param, isl_dim_set, isl_dim_div);
+}
+
+// Sets
+
+void write_set_body( writer & w, isl_set * s )
+{
+    isl_space * space = isl_set_get_space(s);
+    write_space(w, space);
+    isl_space_free(space);
+
+    // Writing may throw, which must not unwind through isl,
+    // so the parts are collected first.
+    std::vector<basic_set> parts;
+    isl_stat status = isl_set_foreach_basic_set(s, [](isl_basic_set * bset, void * user) {
+        static_cast<std::vector<basic_set>*>(user)->emplace_back(bset);
+        return isl_stat_ok;
+    }, &parts);
+    if (status != isl_stat_ok)
+    {
+        context::budget_scope::check();
+        throw error("Can not serialize set.");
+    }
+
+    w.word(parts.size());
+    for (const basic_set & bset : parts)
+        write_basic_set_body(w, bset.get());
+}
+
+set read_set_body( reader & r, const context & ctx )
+{
+    space spc = read_space(r, ctx);
+    std::size_t n = r.count(1);
+
+    set s(isl_set_empty(spc.copy()));
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        basic_set bset = read_basic_set_body(r, ctx, spc);
+        s = isl_set_union(s.release(), isl_set_from_basic_set(bset.release()));
+    }
+    return s;
+}
+
+void write_union_set_body( writer & w, isl_union_set * u )
+{
+    std::vector<set> sets;
+    isl_stat status = isl_union_set_foreach_set(u, [](isl_set * s, void * user) {
+        static_cast<std::vector<set>*>(user)->emplace_back(s);
+        return isl_stat_ok;
+    }, &sets);
+    if (status != isl_stat_ok)
+    {
+        context::budget_scope::check();
+        throw error("Can not serialize union set.");
+    }
+
+    w.word(sets.size());
+    for (const set & s : sets)
+        write_set_body(w, s.get());
+}
+
+// Sets in a union may have different parameters, so each has its own.
+union_set read_union_set_body( reader & r, const context & ctx )
+{
+    std::size_t n = r.count(1);
+    union_set u(isl_union_set_empty(isl_space_params_alloc(ctx.get(), 0)));
+    for (std::size_t i = 0; i < n; ++i)
+        u = isl_union_set_add_set(u.release(), read_set_body(r, ctx).release());
+    return u;
+}
+
+// Objects
+
+void write_header( writer & w, object_kind kind )
+{
+    w.word(magic);
+    w.word(pair(version, kind));
+}
+
+void read_header( reader & r, object_kind kind )
+{
+    if (r.word() != magic)
+        throw error("Not isl-cpp binary data.");
+    uint64_t x = r.word();
+    if ((x & 0xffffffff) != version)
+        throw error("Unsupported binary data version.");
+    if (x >> 32 != kind)
+        throw error("Binary data holds a different kind of object.");
+}
+
+}
+
+void serialize( const basic_set & bset, std::vector<char> & buffer )
+{
+    writer w(buffer);
+    write_header(w, basic_set_kind);
+    isl_space * space = isl_basic_set_get_space(bset.get());
+    write_space(w, space);
+    isl_space_free(space);
+    write_basic_set_body(w, bset.get());
+}
+
+void serialize( const set & s, std::vector<char> & buffer )
+{
+    writer w(buffer);
+    write_header(w, set_kind);
+    write_set_body(w, s.get());
+}
+
+void serialize( const union_set & u, std::vector<char> & buffer )
+{
+    writer w(buffer);
+    write_header(w, union_set_kind);
+    write_union_set_body(w, u.get());
+}
+
+void serialize( const basic_map & bmap, std::vector<char> & buffer )
+{
+    writer w(buffer);
+    write_header(w, basic_map_kind);
+    isl_basic_set * bset = isl_basic_map_wrap(bmap.copy());
+    isl_space * space = isl_basic_set_get_space(bset);
+    write_space(w, space);
+    isl_space_free(space);
+    write_basic_set_body(w, bset);
+    isl_basic_set_free(bset);
+}
+
+void serialize( const map & m, std::vector<char> & buffer )
+{
+    writer w(buffer);
+    write_header(w, map_kind);
+    isl_set * s = isl_map_wrap(m.copy());
+    write_set_body(w, s);
+    isl_set_free(s);
+}
+
+void serialize( const union_map & u, std::vector<char> & buffer )
+{
+    writer w(buffer);
+    write_header(w, union_map_kind);
+    isl_union_set * s = isl_union_map_wrap(u.copy());
+    write_union_set_body(w, s);
+    isl_union_set_free(s);
+}
+
+template <>
+basic_set deserialize<basic_set>( const context & ctx, byte_span data )
+{
+    reader r(data);
+    read_header(r, basic_set_kind);
+    space spc = read_space(r, ctx);
+    return read_basic_set_body(r, ctx, spc);
+}
+
+template <>
+set deserialize<set>( const context & ctx, byte_span data )
+{
+    reader r(data);
+    read_header(r, set_kind);
+    return read_set_body(r, ctx);
+}
+
+template <>
+union_set deserialize<union_set>( const context & ctx, byte_span data )
+{
+    reader r(data);
+    read_header(r, union_set_kind);
+    return read_union_set_body(r, ctx);
+}
+
+template <>
+basic_map deserialize<basic_map>( const context & ctx, byte_span data )
+{
+    reader r(data);
+    read_header(r, basic_map_kind);
+    space spc = read_space(r, ctx);
+    if (isl_space_is_wrapping(spc.get()) != isl_bool_true)
+        throw error("Invalid binary data.");
+    return isl_basic_set_unwrap(read_basic_set_body(r, ctx, spc).release());
+}
+
+template <>
+map deserialize<map>( const context & ctx, byte_span data )
+{
+    reader r(data);
+    read_header(r, map_kind);
+    set s = read_set_body(r, ctx);
+    if (isl_set_is_wrapping(s.get()) != isl_bool_true)
+        throw error("Invalid binary data.");
+    return isl_set_unwrap(s.release());
+}
+
+template <>
+union_map deserialize<union_map>( const context & ctx, byte_span data )
+{
+    reader r(data);
+    read_header(r, union_map_kind);
+    return isl_union_set_unwrap(read_union_set_body(r, ctx).release());
+}
+
+}
@@ -0,0 +1,87 @@
+/*
+isl-cpp: C++ bindings to the ISL (Integer Set Library)
+
+Copyright (C) 2014  Jakob Leben <jakob.leben@gmail.com>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef ISL_CPP_SERIALIZE_INCLUDED
+#define ISL_CPP_SERIALIZE_INCLUDED
+
+#include "context.hpp"
+#include "set.hpp"
+#include "map.hpp"
+
+#include <vector>
+#include <cstddef>
+
+namespace isl {
+
+// A binary format for sets, maps and their unions.
+//
+// An object is stored as its space, with tuple and dimension names,
+// followed by the equality, inequality and integer division matrices
+// of each basic set or map. Maps are stored as wrapped sets.
+//
+// The data is a sequence of 64-bit little endian words with no pointers,
+// so it can be read straight from a memory mapped file. It starts with
+// a header holding a magic number, the format version and the kind of
+// object, which deserialize checks.
+//
+// Small fields share a word, and matrix elements are packed with 8, 16,
+// 32 or 64 bits each, as the largest element needs. Fields stay aligned
+// to words, so reading does not parse text. This costs size: typical
+// sets take two to three times as many bytes as their text form.
+//
+// Identifiers keep only their names, not their user pointers.
+
+// Bytes to read an object from, for example a memory mapped file.
+struct byte_span
+{
+    byte_span( const void * data, std::size_t size ):
+        data(static_cast<const char*>(data)), size(size)
+    {}
+    byte_span( const std::vector<char> & buffer ):
+        data(buffer.data()), size(buffer.size())
+    {}
+
+    const char * data;
+    std::size_t size;
+};
+
+// These append the object to buffer.
+void serialize( const basic_set &, std::vector<char> & buffer );
+void serialize( const set &, std::vector<char> & buffer );
+void serialize( const union_set &, std::vector<char> & buffer );
+void serialize( const basic_map &, std::vector<char> & buffer );
+void serialize( const map &, std::vector<char> & buffer );
+void serialize( const union_map &, std::vector<char> & buffer );
+
+// Reads an object of type T from the start of data.
+// Throws if the data is not a valid object of that type.
+template <typename T>
+T deserialize( const context & ctx, byte_span data );
+
+template <> basic_set deserialize<basic_set>( const context &, byte_span );
+template <> set deserialize<set>( const context &, byte_span );
+template <> union_set deserialize<union_set>( const context &, byte_span );
+template <> basic_map deserialize<basic_map>( const context &, byte_span );
+template <> map deserialize<map>( const context &, byte_span );
+template <> union_map deserialize<union_map>( const context &, byte_span );
+
+}
+
+#endif // ISL_CPP_SERIALIZE_INCLUDED
@@ -1,41 +1,207 @@
 #include "set.hpp"
 #include "expression.hpp"
 #include "constraint.hpp"
+#include "integer.hpp"
+
+#include <isl/aff.h>
+#include <isl/local_space.h>
+
+#include <vector>
 
 namespace isl {
 
+namespace {
+
+void check_countable( isl_set * s )
+{
+    if (isl_set_dim(s, isl_dim_param) != 0)
+        throw error("Can not count points of a set with parameters.");
+    if (checked(isl_set_is_bounded(s)) != isl_bool_true)
+        throw error("Can not count points of an unbounded set.");
+}
+
+isl_val * count_val( isl_set * s )
+{
+    isl_val * v = isl_set_count_val(s);
+    if (!v)
+    {
+        context::budget_scope::check();
+        throw error("Can not count points of set.");
+    }
+    return v;
+}
+
+// Takes v, which must be an integer value, and throws if it
+// does not fit in 64 bits.
+int64_t take_bound( isl_val * v )
+{
+    int64_t x;
+    if (!detail::take_int64(v, x))
+        throw error("Set is too large to count.");
+    return x;
+}
+
+// Counts the points of s, up to limit.
+//
+// isl counts points a row of the innermost variable at a time,
+// so counting is cheap in the number of points, but not in the number
+// of rows. The set is counted in slices along variable dim, of doubling
+// width, and each slice is counted in the same way along the next
+// variable, until the limit is reached.
+int64_t count_upto( const set & s, int64_t limit, int dim )
+{
+    isl_size n = isl_set_dim(s.get(), isl_dim_set);
+    if (n < 0)
+    {
+        context::budget_scope::check();
+        throw error("Can not count points of set.");
+    }
+    if (dim >= n - 1)
+    {
+        int64_t count;
+        if (!detail::take_int64(count_val(s.get()), count) || count > limit)
+            count = limit;
+        return count;
+    }
+
+    isl_aff * var = isl_aff_var_on_domain
+            (isl_local_space_from_space(isl_set_get_space(s.get())), isl_dim_set, dim);
+    isl_val * min = isl_set_min_val(s.get(), var);
+    isl_val * max = isl_set_max_val(s.get(), var);
+    isl_aff_free(var);
+
+    if (!min || !max)
+    {
+        isl_val_free(min);
+        isl_val_free(max);
+        context::budget_scope::check();
+        throw error("Can not count points of set.");
+    }
+
+    // The minimum over an empty set is NaN.
+    if (isl_val_is_nan(min) == isl_bool_true)
+    {
+        isl_val_free(min);
+        isl_val_free(max);
+        return 0;
+    }
+
+    int64_t first = take_bound(min);
+    int64_t last = take_bound(max);
+
+    isl_ctx * ctx = isl_set_get_ctx(s.get());
+    int64_t total = 0;
+    uint64_t width = 1;
+    for (int64_t start = first; total < limit; )
+    {
+        int64_t end = uint64_t(last) - uint64_t(start) < width ? last : int64_t(start + (width - 1));
+
+        isl_set * slice = s.copy();
+        slice = isl_set_lower_bound_val(slice, isl_dim_set, dim, detail::int64_val(ctx, start));
+        slice = isl_set_upper_bound_val(slice, isl_dim_set, dim, detail::int64_val(ctx, end));
+        total += count_upto(set(slice), limit - total, dim + 1);
+
+        if (end == last)
+            break;
+        start = end + 1;
+        if (width < (uint64_t(1) << 62))
+            width *= 2;
+    }
+
+    return total;
+}
+
+// Counting may throw, which must not unwind through isl,
+// so the sets are collected first.
+std::vector<set> sets_of( const union_set & u )
+{
+    std::vector<set> sets;
+    u.for_each([&](const set & s){
+        sets.push_back(s);
+        return true;
+    });
+    return sets;
+}
+
+}
+
+value set::count() const
+{
+    check_countable(get());
+    return count_val(get());
+}
+
+int64_t set::count_upto( int64_t limit ) const
+{
+    if (limit <= 0)
+        return 0;
+    check_countable(get());
+    return isl::count_upto(*this, limit, 0);
+}
+
+value union_set::count() const
+{
+    isl_val * total = isl_val_zero(isl_union_set_get_ctx(get()));
+    for (const set & s : sets_of(*this))
+        total = isl_val_add(total, s.count().release());
+    return total;
+}
+
+int64_t union_set::count_upto( int64_t limit ) const
+{
+    int64_t total = 0;
+    for (const set & s : sets_of(*this))
+    {
+        if (total >= limit)
+            break;
+        total += s.count_upto(limit - total);
+    }
+    return total;
+}
+
 value basic_set::maximum( const expression & expr ) const
 {
     isl_val *v = isl_basic_set_max_val(get(), expr.get());
     if (!v)
+    {
+        context::budget_scope::check();
         throw error("No solution.");
+    }
     return v;
 }
 
 value set::minimum( const expression & expr ) const
 {
-    isl_val *v = isl_set_min_val(get(), expr.get());
+    isl_val *v = cached_result<isl_val>(*this, result_cache::minimum_query, expr.get(),
+                                        [&]{ return isl_set_min_val(get(), expr.get()); });
     if (!v)
+    {
+        context::budget_scope::check();
         throw error("No solution.");
+    }
     return v;
 }
 
 value set::maximum( const expression & expr ) const
 {
-    isl_val *v = isl_set_max_val(get(), expr.get());
+    isl_val *v = cached_result<isl_val>(*this, result_cache::maximum_query, expr.get(),
+                                        [&]{ return isl_set_max_val(get(), expr.get()); });
     if (!v)
+    {
+        context::budget_scope::check();
         throw error("No solution.");
+    }
     return v;
 }
 
 void basic_set::add_constraint( const constraint & c)
 {
-    m_object = isl_basic_set_add_constraint(m_object, c.copy());
+    update(isl_basic_set_add_constraint(m_object, c.copy()));
 }
 
 void set::add_constraint( const constraint & c)
 {
-    m_object = isl_set_add_constraint(m_object, c.copy());
+    update(isl_set_add_constraint(m_object, c.copy()));
 }
 
 }
@@ -27,11 +27,16 @@ along with this program; if not, write to the Free Software Foundation, Inc.,
 #include "space.hpp"
 #include "matrix.hpp"
 #include "printer.hpp"
+#include "result_cache.hpp"
 
 #include <isl/set.h>
 #include <isl/union_set.h>
 #include <isl/ilp.h>
 
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+
 namespace isl {
 
 class basic_map;
@@ -39,6 +44,7 @@ class map;
 class union_map;
 class expression;
 class constraint;
+class worker_pool;
 
 template<>
 struct object_behavior<isl_basic_set>
@@ -130,42 +136,50 @@ public:
 
     bool is_empty() const
     {
-        return isl_basic_set_is_empty(get());
+        return checked(isl_basic_set_is_empty(get()));
     }
     void insert_dimensions( space::dimension_type t, unsigned i, unsigned n=1 )
     {
-        m_object = isl_basic_set_insert_dims(m_object, (isl_dim_type)t, i, n);
+        update(isl_basic_set_insert_dims(m_object, (isl_dim_type)t, i, n));
     }
     void add_dimensions( space::dimension_type t, unsigned n=1 )
     {
-        m_object = isl_basic_set_add_dims(m_object, (isl_dim_type)t, n);
+        update(isl_basic_set_add_dims(m_object, (isl_dim_type)t, n));
     }
     void project_out_dimensions( space::dimension_type t, unsigned i, unsigned n=1 )
     {
-        m_object = isl_basic_set_project_out(m_object, (isl_dim_type)t, i, n);
+        update(isl_basic_set_project_out(m_object, (isl_dim_type)t, i, n));
     }
     void add_constraint( const constraint & c);
     void drop_constraints_with( space::dimension_type t, unsigned i, unsigned n=1)
     {
-        m_object = isl_basic_set_drop_constraints_involving_dims
-                (m_object, (isl_dim_type) t, i, n);
+        update(isl_basic_set_drop_constraints_involving_dims
+                (m_object, (isl_dim_type) t, i, n));
     }
 
     basic_map unwrapped();
 
-    basic_set lifted() const
+    basic_set lifted() const &
     {
         return isl_basic_set_lift(copy());
     }
+    basic_set lifted() &&
+    {
+        return isl_basic_set_lift(release());
+    }
 
-    basic_set flattened() const
+    basic_set flattened() const &
     {
         return isl_basic_set_flatten(copy());
     }
+    basic_set flattened() &&
+    {
+        return isl_basic_set_flatten(release());
+    }
 
     static bool are_disjoint( const basic_set & a, const basic_set & b )
     {
-        return isl_basic_set_is_disjoint(a.get(), b.get());
+        return checked(isl_basic_set_is_disjoint(a.get(), b.get()));
     }
 
     bool is_disjoint(const basic_set & b) const
@@ -175,17 +189,28 @@ public:
 
     bool is_subset_of(const basic_set & other) const
     {
-        return isl_basic_set_is_subset(get(), other.get());
+        return checked(isl_basic_set_is_subset(get(), other.get()));
     }
 
     point single_point() const
     {
         isl_point *p = isl_basic_set_sample_point(copy());
         if (!p)
+        {
+            context::budget_scope::check();
             throw error("No single point.");
+        }
         return p;
     }
 
+    // Like the ones of set.
+    template <typename F>
+    void for_each_point( F f ) const;
+    template <typename F>
+    void for_each_point_batch( F f, std::size_t batch_size = 4096 ) const;
+    value count() const;
+    int64_t count_upto( int64_t limit ) const;
+
     value maximum( const expression & expr ) const;
 
     set lex_minimum() const;
@@ -194,12 +219,12 @@ public:
 #if 0 // Not available?
     basic_set & limit_above(isl::space::dimension_type dim, unsigned pos, int value)
     {
-        m_object = isl_basic_set_upper_bound_si(m_object, (isl_dim_type)dim, pos, value);
+        update(isl_basic_set_upper_bound_si(m_object, (isl_dim_type)dim, pos, value));
         return *this;
     }
     basic_set & limit_below(isl::space::dimension_type dim, unsigned pos, int value)
     {
-        m_object = isl_basic_set_lower_bound_si(m_object, (isl_dim_type)dim, pos, value);
+        update(isl_basic_set_lower_bound_si(m_object, (isl_dim_type)dim, pos, value));
         return *this;
     }
 #endif
@@ -241,13 +266,13 @@ public:
     }
     void set_id(const identifier & id )
     {
-        isl_id *c_id = id.c_id(m_ctx.get());
+        isl_id *c_id = id.c_id(ctx());
         if (c_id)
-            m_object = isl_set_set_tuple_id(get(), c_id);
+            update(isl_set_set_tuple_id(get(), c_id));
     }
     void clear_id()
     {
-        m_object = isl_set_reset_tuple_id(m_object);
+        update(isl_set_reset_tuple_id(m_object));
     }
     string name() const
     {
@@ -255,122 +280,169 @@ public:
     }
     void set_name( const string & name )
     {
-        m_object = isl_set_set_tuple_name(m_object, name.c_str());
+        update(isl_set_set_tuple_name(m_object, name.c_str()));
     }
 
     bool is_empty() const
     {
-        return isl_set_is_empty(get());
+        return cached_answer(*this, result_cache::is_empty_query, {},
+                             [&]{ return isl_set_is_empty(get()); });
+    }
+
+    // A hash of the normalized set, equal for plainly equal sets.
+    // Sets with the same points written differently may hash
+    // differently, so hash containers should compare keys with
+    // plain_equal<set>.
+    std::size_t hash() const
+    {
+        return isl_set_get_hash(get());
     }
 
     bool is_plain_universe() const
     {
-        return isl_set_plain_is_universe(get());
+        return checked(isl_set_plain_is_universe(get()));
     }
 
     bool is_subset_of(const set & other) const
     {
-        return isl_set_is_subset(get(), other.get());
+        return cached_answer(*this, result_cache::is_subset_query, other.get(),
+                             [&]{ return isl_set_is_subset(get(), other.get()); });
     }
 
     bool is_strict_subset_of(const set & other) const
     {
-        return isl_set_is_strict_subset(get(), other.get());
+        return checked(isl_set_is_strict_subset(get(), other.get()));
     }
 
     void add_dimensions( space::dimension_type t, unsigned n=1 )
     {
-        m_object = isl_set_add_dims(m_object, (isl_dim_type) t, n);
+        update(isl_set_add_dims(m_object, (isl_dim_type) t, n));
     }
     void project_out_dimensions( space::dimension_type t, unsigned i, unsigned n=1 )
     {
-        m_object = isl_set_project_out(m_object, (isl_dim_type)t, i, n);
+        update(isl_set_project_out(m_object, (isl_dim_type)t, i, n));
     }
 
     value minimum( const expression & expr ) const;
     value maximum( const expression & expr ) const;
 
-    set lex_minimum() const
+    set lex_minimum() const &
+    {
+        return cached_result<isl_set>(*this, result_cache::lex_minimum_query, {},
+                                      [&]{ return isl_set_lexmin(copy()); });
+    }
+    set lex_minimum() &&
     {
-        return isl_set_lexmin(copy());
+        return cached_result<isl_set>(*this, result_cache::lex_minimum_query, {},
+                                      [&]{ return isl_set_lexmin(release()); });
     }
-    set lex_maximum() const
+    set lex_maximum() const &
     {
-        return isl_set_lexmax(copy());
+        return cached_result<isl_set>(*this, result_cache::lex_maximum_query, {},
+                                      [&]{ return isl_set_lexmax(copy()); });
+    }
+    set lex_maximum() &&
+    {
+        return cached_result<isl_set>(*this, result_cache::lex_maximum_query, {},
+                                      [&]{ return isl_set_lexmax(release()); });
     }
     void coalesce()
     {
-        m_object = isl_set_coalesce(m_object);
+        *this = cached_in_place_result<isl_set>(*this, result_cache::coalesce_query,
+                                                [&]{ return isl_set_coalesce(release()); });
     }
     void insert_dimensions( unsigned pos, unsigned count )
     {
-        m_object = isl_set_insert_dims(m_object, isl_dim_set, pos, count);
+        update(isl_set_insert_dims(m_object, isl_dim_set, pos, count));
     }
     void add_constraint( const constraint & c);
     void drop_constraints_with( space::dimension_type t, unsigned i, unsigned n=1)
     {
-        m_object = isl_set_drop_constraints_involving_dims
-                (m_object, (isl_dim_type) t, i, n);
+        update(isl_set_drop_constraints_involving_dims
+                (m_object, (isl_dim_type) t, i, n));
     }
 
     set & limit_above(isl::space::dimension_type dim, unsigned pos, int value)
     {
-        m_object = isl_set_upper_bound_si(m_object, (isl_dim_type)dim, pos, value);
+        update(isl_set_upper_bound_si(m_object, (isl_dim_type)dim, pos, value));
         return *this;
     }
     set & limit_below(isl::space::dimension_type dim, unsigned pos, int value)
     {
-        m_object = isl_set_lower_bound_si(m_object, (isl_dim_type)dim, pos, value);
+        update(isl_set_lower_bound_si(m_object, (isl_dim_type)dim, pos, value));
         return *this;
     }
 
     map unwrapped();
 
-    set lifted() const
+    set lifted() const &
     {
         return isl_set_lift(copy());
     }
+    set lifted() &&
+    {
+        return isl_set_lift(release());
+    }
 
-    set flattened() const
+    set flattened() const &
     {
         return isl_set_flatten(copy());
     }
+    set flattened() &&
+    {
+        return isl_set_flatten(release());
+    }
 
-    set parameters() const
+    set parameters() const &
     {
         return isl_set_params(copy());
     }
+    set parameters() &&
+    {
+        return isl_set_params(release());
+    }
 
     set equate(int dim1, int dim2) const
     {
         return isl_set_equate(copy(), isl_dim_set, dim1, isl_dim_set, dim2);
     }
 
-    basic_set convex_hull() const
+    basic_set convex_hull() const &
     {
         return isl_set_convex_hull(copy());
     }
-    basic_set simple_hull() const
+    basic_set convex_hull() &&
+    {
+        return isl_set_convex_hull(release());
+    }
+    basic_set simple_hull() const &
     {
         return isl_set_simple_hull(copy());
     }
+    basic_set simple_hull() &&
+    {
+        return isl_set_simple_hull(release());
+    }
 
     bool is_singleton() const
     {
-        return isl_set_is_singleton(get());
+        return checked(isl_set_is_singleton(get()));
     }
 
     point single_point() const
     {
         isl_point *p = isl_set_sample_point(copy());
         if (!p)
+        {
+            context::budget_scope::check();
             throw error("No single point.");
+        }
         return p;
     }
 
     static bool are_disjoint( const set & a, const set & b )
     {
-        return isl_set_is_disjoint(a.get(), b.get());
+        return checked(isl_set_is_disjoint(a.get(), b.get()));
     }
 
     bool is_disjoint(const set & b) const
@@ -383,6 +455,56 @@ public:
         isl_set_foreach_basic_set(get(), &for_each_basic_set_helper<F>, &f);
     }
 
+    // The number of integer points.
+    // The set must be bounded and have no parameters.
+    value count() const;
+
+    // The number of integer points, or limit if there are at least
+    // that many. Counts only as much of the set as needed to tell.
+    int64_t count_upto( int64_t limit ) const;
+
+    // Calls f with each integer point, until f returns false.
+    // The set must be bounded. Exceptions thrown by f are passed on.
+    template <typename F>
+    void for_each_point( F f ) const
+    {
+        point_visit<F> visit { f, nullptr, false };
+        isl_stat result = isl_set_foreach_point(get(), &for_each_point_helper<F>, &visit);
+        if (visit.exception)
+            std::rethrow_exception(visit.exception);
+        if (result != isl_stat_ok && !visit.stopped)
+        {
+            context::budget_scope::check();
+            throw error("Can not enumerate points of set.");
+        }
+    }
+
+    // Calls f with batches of up to batch_size integer points, as a
+    // const point_batch &, until f returns false. Only the last batch
+    // may be smaller. Throws if a coordinate does not fit in 64 bits,
+    // and if batch_size is zero.
+    template <typename F>
+    void for_each_point_batch( F f, std::size_t batch_size = 4096 ) const
+    {
+        if (batch_size == 0)
+            throw error("Point batch size must not be zero.");
+        isl_size n = isl_set_dim(get(), isl_dim_set);
+        point_batch batch(n < 0 ? 0 : n, batch_size);
+        const point_batch & full_batch = batch;
+        bool go_on = true;
+        for_each_point([&](const point & pt){
+            batch.push_back(pt);
+            if (batch.full())
+            {
+                go_on = f(full_batch);
+                batch.clear();
+            }
+            return go_on;
+        });
+        if (go_on && batch.size())
+            f(full_batch);
+    }
+
 private:
     template <typename F>
     static isl_stat for_each_basic_set_helper(isl_basic_set *bs_ptr, void *data_ptr)
@@ -392,8 +514,57 @@ private:
         bool result = (*f_ptr)(bs);
         return result ? isl_stat_ok : isl_stat_error;
     }
+
+    template <typename F>
+    struct point_visit
+    {
+        F & f;
+        std::exception_ptr exception;
+        bool stopped;
+    };
+
+    // Exceptions must not unwind through isl, so they are
+    // caught here and rethrown by for_each_point.
+    template <typename F>
+    static isl_stat for_each_point_helper(isl_point *pt_ptr, void *data_ptr)
+    {
+        auto visit = reinterpret_cast<point_visit<F>*>(data_ptr);
+        try {
+            point pt(pt_ptr);
+            visit->stopped = !visit->f(pt);
+        }
+        catch (...) {
+            visit->exception = std::current_exception();
+            visit->stopped = true;
+        }
+        return visit->stopped ? isl_stat_error : isl_stat_ok;
+    }
 };
 
+template <typename F>
+void basic_set::for_each_point( F f ) const
+{
+    set(*this).for_each_point(f);
+}
+
+template <typename F>
+void basic_set::for_each_point_batch( F f, std::size_t batch_size ) const
+{
+    set(*this).for_each_point_batch(f, batch_size);
+}
+
+inline
+value basic_set::count() const
+{
+    return set(*this).count();
+}
+
+inline
+int64_t basic_set::count_upto( int64_t limit ) const
+{
+    return set(*this).count_upto(limit);
+}
+
 class union_set : public object<isl_union_set>
 {
 public:
@@ -419,28 +590,36 @@ public:
     }
     bool is_empty() const
     {
-        return isl_union_set_is_empty(get());
+        return checked(isl_union_set_is_empty(get()));
     }
     bool is_subset_of(const union_set & other) const
     {
-        return isl_union_set_is_subset(get(), other.get());
+        return checked(isl_union_set_is_subset(get(), other.get()));
     }
     bool is_strict_subset_of(const union_set & other) const
     {
-        return isl_union_set_is_strict_subset(get(), other.get());
+        return checked(isl_union_set_is_strict_subset(get(), other.get()));
     }
 
     union_map unwrapped();
 
-    union_set lifted() const
+    union_set lifted() const &
     {
         return isl_union_set_lift(copy());
     }
+    union_set lifted() &&
+    {
+        return isl_union_set_lift(release());
+    }
 
-    union_set universe() const
+    union_set universe() const &
     {
         return isl_union_set_universe(copy());
     }
+    union_set universe() &&
+    {
+        return isl_union_set_universe(release());
+    }
 
     set set_for( const space & spc ) const
     {
@@ -451,16 +630,38 @@ public:
     {
         auto the_set = isl_set_from_union_set(copy());
         if (!the_set)
+        {
+            context::budget_scope::check();
             throw error("No single set.");
+        }
         return the_set;
     }
 
+    // Like the ones of set, over all sets of the union.
+    value count() const;
+    int64_t count_upto( int64_t limit ) const;
+
     template <typename F>
     void for_each( F f ) const
     {
         isl_union_set_foreach_set(get(), &for_each_helper<F>, &f);
     }
 
+    // Calls f on each component in parallel, on the workers of the pool.
+    // Each component is passed to f in the context of its worker.
+    // Each worker calls its own copy of f, so state shared between
+    // the copies, such as variables captured by reference, must be
+    // safe to use from several threads at once.
+    // Defined in parallel.hpp.
+    template <typename F>
+    void parallel_for_each( worker_pool & pool, F f ) const;
+
+    // Like parallel_for_each, but collects the results of f
+    // into a union in the context of this one.
+    // Defined in parallel.hpp.
+    template <typename F>
+    union_set parallel_transform( worker_pool & pool, F f ) const;
+
 private:
     template <typename F>
     static isl_stat for_each_helper(isl_set *set_ptr, void *data_ptr)
@@ -490,6 +691,12 @@ set operator!( const set & s )
     isl_set *x = isl_set_complement(s.copy());
     return set(x);
 }
+inline
+set operator!( set && s )
+{
+    isl_set *x = isl_set_complement(s.release());
+    return set(x);
+}
 
 inline
 set operator&( const set & lhs, const set & rhs )
@@ -498,26 +705,43 @@ set operator&( const set & lhs, const set & rhs )
     return set(x);
 }
 inline
+set operator&( set && lhs, const set & rhs )
+{
+    isl_set *x = isl_set_intersect(lhs.release(), rhs.copy());
+    return set(x);
+}
+inline
 basic_set operator&( const basic_set & lhs, const basic_set & rhs )
 {
     isl_basic_set *x = isl_basic_set_intersect(lhs.copy(), rhs.copy());
     return basic_set(x);
 }
 inline
+basic_set operator&( basic_set && lhs, const basic_set & rhs )
+{
+    isl_basic_set *x = isl_basic_set_intersect(lhs.release(), rhs.copy());
+    return basic_set(x);
+}
+inline
 union_set operator&( const union_set & lhs, const union_set & rhs )
 {
     return isl_union_set_intersect(lhs.copy(), rhs.copy());
 }
 inline
+union_set operator&( union_set && lhs, const union_set & rhs )
+{
+    return isl_union_set_intersect(lhs.release(), rhs.copy());
+}
+inline
 set & operator&=(set & lhs, const set & rhs )
 {
-    lhs = lhs & rhs;
+    lhs = std::move(lhs) & rhs;
     return lhs;
 }
 inline
 union_set & operator&=(union_set & lhs, const union_set & rhs )
 {
-    lhs = lhs & rhs;
+    lhs = std::move(lhs) & rhs;
     return lhs;
 }
 
@@ -528,36 +752,63 @@ set operator|( const set & lhs, const set & rhs )
     return set(u);
 }
 inline
+set operator|( set && lhs, const set & rhs )
+{
+    isl_set *u = isl_set_union(lhs.release(), rhs.copy());
+    return set(u);
+}
+inline
 set operator|( const basic_set & lhs, const basic_set & rhs )
 {
     isl_set *u = isl_basic_set_union(lhs.copy(), rhs.copy());
     return set(u);
 }
 inline
+set operator|( basic_set && lhs, const basic_set & rhs )
+{
+    isl_set *u = isl_basic_set_union(lhs.release(), rhs.copy());
+    return set(u);
+}
+inline
 union_set operator| (const union_set &lhs, const union_set & rhs)
 {
     return isl_union_set_union(lhs.copy(), rhs.copy());
 }
 inline
+union_set operator| (union_set && lhs, const union_set & rhs)
+{
+    return isl_union_set_union(lhs.release(), rhs.copy());
+}
+inline
 union_set operator| (const union_set &lhs, const set & rhs)
 {
     return isl_union_set_union(lhs.copy(), isl_union_set_from_set(rhs.copy()));
 }
 inline
+union_set operator| (union_set && lhs, const set & rhs)
+{
+    return isl_union_set_union(lhs.release(), isl_union_set_from_set(rhs.copy()));
+}
+inline
 union_set operator| (const union_set &lhs, const basic_set & rhs)
 {
     return isl_union_set_union(lhs.copy(), isl_union_set_from_basic_set(rhs.copy()));
 }
 inline
+union_set operator| (union_set && lhs, const basic_set & rhs)
+{
+    return isl_union_set_union(lhs.release(), isl_union_set_from_basic_set(rhs.copy()));
+}
+inline
 set & operator|=(set & lhs, const set & rhs )
 {
-    lhs = lhs | rhs;
+    lhs = std::move(lhs) | rhs;
     return lhs;
 }
 inline
 union_set & operator|=(union_set & lhs, const union_set & rhs )
 {
-    lhs = lhs | rhs;
+    lhs = std::move(lhs) | rhs;
     return lhs;
 }
 
@@ -567,35 +818,92 @@ set operator* ( const set & lhs, const set & rhs )
     return isl_set_product(lhs.copy(), rhs.copy());
 }
 inline
+set operator* ( set && lhs, const set & rhs )
+{
+    return isl_set_product(lhs.release(), rhs.copy());
+}
+inline
 union_set operator* ( const union_set & lhs, const union_set & rhs )
 {
     return isl_union_set_product(lhs.copy(), rhs.copy());
 }
+inline
+union_set operator* ( union_set && lhs, const union_set & rhs )
+{
+    return isl_union_set_product(lhs.release(), rhs.copy());
+}
 
 inline
 set operator- (const set & lhs, const set & rhs)
 {
     return isl_set_subtract(lhs.copy(), rhs.copy());
 }
+inline
+set operator- (set && lhs, const set & rhs)
+{
+    return isl_set_subtract(lhs.release(), rhs.copy());
+}
 
 inline
 union_set operator- (const union_set & lhs, const union_set & rhs)
 {
     return isl_union_set_subtract(lhs.copy(), rhs.copy());
 }
+inline
+union_set operator- (union_set && lhs, const union_set & rhs)
+{
+    return isl_union_set_subtract(lhs.release(), rhs.copy());
+}
 
 inline
 bool operator==( const basic_set & lhs, const basic_set & rhs)
 {
-    return isl_basic_set_is_equal(lhs.get(), rhs.get());
+    // Interned objects share the same isl object.
+    if (lhs.get() == rhs.get())
+        return true;
+    return checked(isl_basic_set_is_equal(lhs.get(), rhs.get()));
 }
 
 inline
 bool operator==( const set & lhs, const set & rhs)
 {
-    return isl_set_is_equal(lhs.get(), rhs.get());
+    if (lhs.get() == rhs.get())
+        return true;
+    if (checked(isl_set_plain_is_equal(lhs.get(), rhs.get())))
+        return true;
+    return checked(isl_set_is_equal(lhs.get(), rhs.get()));
+}
+
+inline
+bool operator!=( const set & lhs, const set & rhs)
+{
+    return !(lhs == rhs);
 }
 
+// Orders sets by their representation. Sets are equivalent
+// exactly when they are plainly equal, which is stricter than
+// operator==, so use plain_equal<set> with std::unique after sorting.
+inline
+bool operator<( const set & lhs, const set & rhs)
+{
+    return isl_set_plain_cmp(lhs.get(), rhs.get()) < 0;
+}
+
+// Equality of representation, consistent with hash() and
+// operator<, for use as the key equality of hash containers.
+template <typename T> struct plain_equal;
+
+template <>
+struct plain_equal<set>
+{
+    bool operator()( const set & lhs, const set & rhs ) const
+    {
+        if (lhs.get() == rhs.get())
+            return true;
+        return isl_set_plain_cmp(lhs.get(), rhs.get()) == 0;
+    }
+};
+
 template <> inline
 void printer::print<basic_set>( const basic_set & s )
 {
@@ -616,20 +924,43 @@ template <> inline
 void printer::print_each_in<set>(const set & u)
 {
     u.for_each([this](const basic_set & s){
-        print(s); std::cout << std::endl;
+        print(s); end_line();
         return true;
     });
 }
 
+template <> inline
+void printer::print_all<set>(const set & u)
+{
+    print_each_in(u);
+    flush();
+}
+
 template <> inline
 void printer::print_each_in<union_set>(const union_set & us)
 {
     us.for_each([this](const set & s){
-        print(s); std::cout << std::endl;
+        print(s); end_line();
         return true;
     });
 }
+
+template <> inline
+void printer::print_all<union_set>(const union_set & us)
+{
+    print_each_in(us);
+    flush();
+}
 }
 
+namespace std {
+
+template<>
+struct hash<isl::set>
+{
+    size_t operator()( const isl::set & s ) const { return s.hash(); }
+};
+
+}
 
 #endif // ISL_CPP_SET_INCLUDED
@@ -0,0 +1,397 @@
+/*
+isl-cpp: C++ bindings to the ISL (Integer Set Library)
+
+Copyright (C) 2014  Jakob Leben <jakob.leben@gmail.com>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "small_matrix.hpp"
+
+#include <algorithm>
+#include <climits>
+
+namespace isl {
+
+namespace {
+
+const unsigned line_elements = 64 / sizeof(int64_t);
+
+uint64_t magnitude( int64_t x )
+{
+    return x < 0 ? uint64_t(-(x + 1)) + 1 : uint64_t(x);
+}
+
+// x -= m * y
+bool sub_mul( int64_t & x, int64_t m, int64_t y )
+{
+    int64_t p;
+    if (__builtin_mul_overflow(m, y, &p))
+        return false;
+    return !__builtin_sub_overflow(x, p, &x);
+}
+
+// x += m * y
+bool add_mul( int64_t & x, int64_t m, int64_t y )
+{
+    int64_t p;
+    if (__builtin_mul_overflow(m, y, &p))
+        return false;
+    return !__builtin_add_overflow(x, p, &x);
+}
+
+bool negate( int64_t & x )
+{
+    if (x == INT64_MIN)
+        return false;
+    x = -x;
+    return true;
+}
+
+// Quotient rounded down (ceil = false) or up (ceil = true).
+bool divide( int64_t a, int64_t b, bool ceil, int64_t & q )
+{
+    if (a == INT64_MIN && b == -1)
+        return false;
+    q = a / b;
+    int64_t r = a % b;
+    if (r != 0)
+    {
+        bool negative = (r < 0) != (b < 0);
+        if (negative && !ceil)
+            --q;
+        else if (!negative && ceil)
+            ++q;
+    }
+    return true;
+}
+
+// The elementary column operations of the Hermite decomposition.
+// They act on the rows of h from row on and on all rows of u,
+// like their counterparts in isl_mat.c.
+
+void exchange( small_matrix & h, small_matrix * u, unsigned row,
+               unsigned i, unsigned j )
+{
+    for (unsigned r = row; r < h.rows(); ++r)
+        std::swap(h(r, i), h(r, j));
+    if (u)
+        for (unsigned r = 0; r < u->rows(); ++r)
+            std::swap((*u)(r, i), (*u)(r, j));
+}
+
+bool subtract( small_matrix & h, small_matrix * u, unsigned row,
+               unsigned i, unsigned j, int64_t m )
+{
+    for (unsigned r = row; r < h.rows(); ++r)
+        if (!sub_mul(h(r, j), m, h(r, i)))
+            return false;
+    if (u)
+        for (unsigned r = 0; r < u->rows(); ++r)
+            if (!sub_mul((*u)(r, j), m, (*u)(r, i)))
+                return false;
+    return true;
+}
+
+bool oppose( small_matrix & h, small_matrix * u, unsigned row, unsigned col )
+{
+    for (unsigned r = row; r < h.rows(); ++r)
+        if (!negate(h(r, col)))
+            return false;
+    if (u)
+        for (unsigned r = 0; r < u->rows(); ++r)
+            if (!negate((*u)(r, col)))
+                return false;
+    return true;
+}
+
+int first_non_zero( const int64_t * p, unsigned from, unsigned to )
+{
+    for (unsigned i = from; i < to; ++i)
+        if (p[i] != 0)
+            return i;
+    return -1;
+}
+
+int abs_min_non_zero( const int64_t * p, unsigned from, unsigned to )
+{
+    int min = first_non_zero(p, from, to);
+    if (min < 0)
+        return -1;
+    for (unsigned i = min + 1; i < to; ++i)
+        if (p[i] != 0 && magnitude(p[i]) < magnitude(p[min]))
+            min = i;
+    return min;
+}
+
+// Number of leading non-zero columns of a matrix in column echelon form.
+unsigned echelon_rank( const small_matrix & h )
+{
+    unsigned rank = 0;
+    unsigned i = 0;
+    for (; rank < h.columns(); ++rank)
+    {
+        while (i < h.rows() && h(i, rank) == 0)
+            ++i;
+        if (i >= h.rows())
+            break;
+    }
+    return rank;
+}
+
+uint64_t max_magnitude( const small_matrix & m )
+{
+    uint64_t max = 0;
+    for (unsigned r = 0; r < m.rows(); ++r)
+    {
+        const int64_t * row = m.row(r);
+        for (unsigned c = 0; c < m.columns(); ++c)
+            max = std::max(max, magnitude(row[c]));
+    }
+    return max;
+}
+
+}
+
+small_matrix::small_matrix( unsigned rows, unsigned columns )
+{
+    allocate(rows, columns);
+}
+
+small_matrix::small_matrix( const small_matrix & other )
+{
+    copy_from(other);
+}
+
+small_matrix & small_matrix::operator=( const small_matrix & other )
+{
+    if (this != &other)
+        copy_from(other);
+    return *this;
+}
+
+void small_matrix::allocate( unsigned rows, unsigned columns )
+{
+    m_rows = rows;
+    m_columns = columns;
+    m_stride = (columns + line_elements - 1) / line_elements * line_elements;
+
+    // Over-allocate by a line so the data can start on a line boundary.
+    m_storage.assign(std::size_t(rows) * m_stride + line_elements, 0);
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(m_storage.data());
+    std::uintptr_t misalignment = address % 64;
+    std::size_t offset = misalignment ? (64 - misalignment) / sizeof(int64_t) : 0;
+    m_data = m_storage.data() + offset;
+}
+
+void small_matrix::copy_from( const small_matrix & other )
+{
+    allocate(other.m_rows, other.m_columns);
+    for (unsigned r = 0; r < m_rows; ++r)
+        std::copy(other.row(r), other.row(r) + m_columns, row(r));
+}
+
+small_matrix small_matrix::identity( unsigned size )
+{
+    small_matrix m(size, size);
+    for (unsigned i = 0; i < size; ++i)
+        m(i, i) = 1;
+    return m;
+}
+
+bool small_matrix::from_matrix( const matrix & m, small_matrix & result )
+{
+    std::vector<int64_t> data;
+    if (!m.to_int64(data))
+        return false;
+
+    unsigned rows = m.row_count();
+    unsigned cols = m.column_count();
+    result.allocate(rows, cols);
+    for (unsigned r = 0; r < rows; ++r)
+        std::copy(data.begin() + r * cols, data.begin() + (r + 1) * cols, result.row(r));
+    return true;
+}
+
+matrix small_matrix::to_matrix( const context & ctx ) const
+{
+    std::vector<int64_t> data(std::size_t(m_rows) * m_columns);
+    for (unsigned r = 0; r < m_rows; ++r)
+        std::copy(row(r), row(r) + m_columns, data.begin() + r * m_columns);
+    return matrix::from_int64(ctx, m_rows, m_columns, data.data());
+}
+
+// Follows isl_mat_left_hermite with neg = 0.
+bool small_matrix::left_hermite( small_matrix & h, small_matrix * u ) const
+{
+    h = *this;
+    if (u)
+        *u = identity(m_columns);
+
+    unsigned col = 0;
+    for (unsigned row = 0; row < m_rows && col < m_columns; ++row)
+    {
+        int64_t * p = h.row(row);
+
+        int first = abs_min_non_zero(p, col, m_columns);
+        if (first < 0)
+            continue;
+        if ((unsigned) first != col)
+            exchange(h, u, row, first, col);
+        if (p[col] < 0 && !oppose(h, u, row, col))
+            return false;
+
+        unsigned next = col + 1;
+        int off;
+        while ((off = first_non_zero(p, next, m_columns)) >= 0)
+        {
+            next = off;
+            int64_t q;
+            if (!divide(p[next], p[col], false, q))
+                return false;
+            if (!subtract(h, u, row, col, next, q))
+                return false;
+            if (p[next] != 0)
+                exchange(h, u, row, next, col);
+            else
+                ++next;
+        }
+
+        for (unsigned i = 0; i < col; ++i)
+        {
+            if (p[i] == 0)
+                continue;
+            int64_t q;
+            if (!divide(p[i], p[col], false, q))
+                return false;
+            if (q == 0)
+                continue;
+            if (!subtract(h, u, row, col, i, q))
+                return false;
+        }
+
+        ++col;
+    }
+
+    return true;
+}
+
+// Follows isl_mat_right_kernel.
+bool small_matrix::right_kernel( small_matrix & k ) const
+{
+    small_matrix h, u;
+    if (!left_hermite(h, &u))
+        return false;
+
+    unsigned rank = echelon_rank(h);
+
+    k.allocate(u.rows(), u.columns() - rank);
+    for (unsigned r = 0; r < u.rows(); ++r)
+        std::copy(u.row(r) + rank, u.row(r) + u.columns(), k.row(r));
+    return true;
+}
+
+bool small_matrix::rank( unsigned & r ) const
+{
+    small_matrix h;
+    if (!left_hermite(h))
+        return false;
+    r = echelon_rank(h);
+    return true;
+}
+
+bool small_matrix::product( const small_matrix & a, const small_matrix & b,
+                            small_matrix & result )
+{
+    if (a.columns() != b.rows())
+        throw error("Matrix dimensions do not match.");
+
+    result.allocate(a.rows(), b.columns());
+
+    // When the elements are small enough that no sum of products can
+    // overflow, the inner loop needs no checks and vectorizes.
+    uint64_t bound = max_magnitude(a);
+    bool fast = __builtin_mul_overflow(bound, max_magnitude(b), &bound) == false &&
+            __builtin_mul_overflow(bound, uint64_t(a.columns()), &bound) == false &&
+            bound <= uint64_t(INT64_MAX);
+
+    for (unsigned i = 0; i < a.rows(); ++i)
+    {
+        int64_t * out = result.row(i);
+        for (unsigned k = 0; k < a.columns(); ++k)
+        {
+            int64_t x = a(i, k);
+            if (x == 0)
+                continue;
+            const int64_t * in = b.row(k);
+            if (fast)
+            {
+                for (unsigned j = 0; j < b.columns(); ++j)
+                    out[j] += x * in[j];
+            }
+            else
+            {
+                for (unsigned j = 0; j < b.columns(); ++j)
+                    if (!add_mul(out[j], x, in[j]))
+                        return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+matrix left_hermite( const small_matrix & m, const context & ctx, matrix * u )
+{
+    small_matrix h;
+    small_matrix small_u;
+    if (m.left_hermite(h, u ? &small_u : nullptr))
+    {
+        if (u)
+            *u = small_u.to_matrix(ctx);
+        return h.to_matrix(ctx);
+    }
+
+    matrix::hermite_form f = m.to_matrix(ctx).left_hermite();
+    if (u)
+        *u = f.u;
+    return f.h;
+}
+
+matrix right_kernel( const small_matrix & m, const context & ctx )
+{
+    small_matrix k;
+    if (m.right_kernel(k))
+        return k.to_matrix(ctx);
+    return m.to_matrix(ctx).right_kernel();
+}
+
+unsigned rank( const small_matrix & m, const context & ctx )
+{
+    unsigned r;
+    if (m.rank(r))
+        return r;
+    return m.to_matrix(ctx).rank();
+}
+
+matrix product( const small_matrix & a, const small_matrix & b, const context & ctx )
+{
+    small_matrix p;
+    if (small_matrix::product(a, b, p))
+        return p.to_matrix(ctx);
+    return matrix(isl_mat_product(a.to_matrix(ctx).release(), b.to_matrix(ctx).release()));
+}
+
+}
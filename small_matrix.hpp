@@ -0,0 +1,104 @@
+/*
+isl-cpp: C++ bindings to the ISL (Integer Set Library)
+
+Copyright (C) 2014  Jakob Leben <jakob.leben@gmail.com>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef ISL_CPP_SMALL_MATRIX_INCLUDED
+#define ISL_CPP_SMALL_MATRIX_INCLUDED
+
+#include "context.hpp"
+#include "matrix.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace isl {
+
+// A dense integer matrix with 64-bit elements, for the small
+// constraint systems where isl's arbitrary precision is not needed.
+//
+// Rows are padded to whole cache lines and start on a cache line
+// boundary, so loops over a row vectorize well.
+//
+// The algorithms detect overflow and return false when it happens,
+// leaving their results unspecified. The free functions below then
+// redo the computation with isl_mat.
+//
+// left_hermite and right_kernel follow the steps of isl's own
+// implementation, so when nothing overflows they give the same
+// results as isl.
+
+class small_matrix
+{
+public:
+    small_matrix(): small_matrix(0, 0) {}
+    // Initialized to zero.
+    small_matrix( unsigned rows, unsigned columns );
+
+    small_matrix( const small_matrix & other );
+    small_matrix & operator=( const small_matrix & other );
+
+    static small_matrix identity( unsigned size );
+
+    // Returns false if some element does not fit in 64 bits.
+    static bool from_matrix( const matrix & m, small_matrix & result );
+    matrix to_matrix( const context & ctx ) const;
+
+    unsigned rows() const { return m_rows; }
+    unsigned columns() const { return m_columns; }
+
+    int64_t * row( unsigned r ) { return m_data + r * m_stride; }
+    const int64_t * row( unsigned r ) const { return m_data + r * m_stride; }
+
+    int64_t & operator()( unsigned r, unsigned c ) { return row(r)[c]; }
+    int64_t operator()( unsigned r, unsigned c ) const { return row(r)[c]; }
+
+    // Computes h = this * u in column echelon form,
+    // with u unimodular if requested.
+    bool left_hermite( small_matrix & h, small_matrix * u = nullptr ) const;
+
+    // The columns of k span the integer kernel of this matrix.
+    bool right_kernel( small_matrix & k ) const;
+
+    bool rank( unsigned & r ) const;
+
+    static bool product( const small_matrix & a, const small_matrix & b,
+                         small_matrix & result );
+
+private:
+    void allocate( unsigned rows, unsigned columns );
+    void copy_from( const small_matrix & other );
+
+    unsigned m_rows;
+    unsigned m_columns;
+    // Elements per row, including padding.
+    unsigned m_stride;
+    std::vector<int64_t> m_storage;
+    int64_t * m_data;
+};
+
+// These use 64-bit arithmetic when possible and isl_mat otherwise.
+matrix left_hermite( const small_matrix & m, const context & ctx, matrix * u = nullptr );
+matrix right_kernel( const small_matrix & m, const context & ctx );
+unsigned rank( const small_matrix & m, const context & ctx );
+matrix product( const small_matrix & a, const small_matrix & b, const context & ctx );
+
+}
+
+#endif // ISL_CPP_SMALL_MATRIX_INCLUDED
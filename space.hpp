@@ -31,6 +31,9 @@ along with this program; if not, write to the Free Software Foundation, Inc.,
 #include <string>
 #include <vector>
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
 
 namespace isl {
 
@@ -51,6 +54,14 @@ public:
         m_name(isl_id_get_name(c_id)),
         m_data(isl_id_get_user(c_id))
     {}
+    // Returns a new reference to the id, cached in ctx.
+    isl_id *c_id(const context & ctx) const
+    {
+        if (empty())
+            return nullptr;
+        return ctx.id(m_name, m_data);
+    }
+
     isl_id *c_id(isl_ctx *c_ctx) const
     {
         const char *c_name = m_name.empty() ? nullptr : m_name.c_str();
@@ -65,11 +76,38 @@ public:
     void * data() const { return m_data; }
     const string & name() const { return m_name; }
 
+    // The same hash as used by the id cache of a context.
+    std::size_t hash() const
+    {
+        return std::hash<string>()(m_name) * 31 + std::hash<void*>()(m_data);
+    }
+
 private:
     string m_name;
     void * m_data;
 };
 
+inline
+bool operator==( const identifier & lhs, const identifier & rhs )
+{
+    return lhs.data() == rhs.data() && lhs.name() == rhs.name();
+}
+
+inline
+bool operator!=( const identifier & lhs, const identifier & rhs )
+{
+    return !(lhs == rhs);
+}
+
+inline
+bool operator<( const identifier & lhs, const identifier & rhs )
+{
+    int cmp = lhs.name().compare(rhs.name());
+    if (cmp != 0)
+        return cmp < 0;
+    return std::less<void*>()(lhs.data(), rhs.data());
+}
+
 class tuple
 {
 public:
@@ -113,6 +151,7 @@ class space : public object<isl_space>
     friend class set;
     friend class map;
     friend class constraint;
+    friend class space_cache;
 
 public:
     enum dimension_type
@@ -131,36 +170,36 @@ public:
     space( const context & ctx, const parameter_tuple & params ):
         object(ctx, isl_space_params_alloc(ctx.get(), params.size()))
     {
-        set_identifiers(parameter, params);
+        set_identifiers(ctx, parameter, params);
     }
 
     space( const context & ctx, const tuple & params, const tuple & vars ):
         object(ctx, isl_space_set_alloc(ctx.get(), params.size(), vars.size()))
     {
-        set_identifiers(parameter, params);
-        set_identifiers(variable, vars);
+        set_identifiers(ctx, parameter, params);
+        set_identifiers(ctx, variable, vars);
     }
 
     space( const context & ctx, const set_tuple & vars ):
         object(ctx, isl_space_set_alloc(ctx.get(), 0, vars.size()))
     {
-        set_identifiers(variable, vars);
+        set_identifiers(ctx, variable, vars);
     }
 
     space( const context & ctx, const tuple & params,
            const tuple & in, const tuple & out ):
         object(ctx, isl_space_alloc(ctx.get(), params.size(), in.size(), out.size()))
     {
-        set_identifiers(parameter, params);
-        set_identifiers(input, in);
-        set_identifiers(output, out);
+        set_identifiers(ctx, parameter, params);
+        set_identifiers(ctx, input, in);
+        set_identifiers(ctx, output, out);
     }
 
     space( const context & ctx, const input_tuple & in, const output_tuple & out ):
         object(ctx, isl_space_alloc(ctx.get(), 0, in.size(), out.size()))
     {
-        set_identifiers(input, in);
-        set_identifiers(output, out);
+        set_identifiers(ctx, input, in);
+        set_identifiers(ctx, output, out);
     }
 
     static space for_parameters( const context & ctx, int param_count )
@@ -231,18 +270,43 @@ public:
 
     void add_dimensions( space::dimension_type t, unsigned n=1 )
     {
-        m_object = isl_space_add_dims(m_object, (isl_dim_type) t, n );
+        update(isl_space_add_dims(m_object, (isl_dim_type) t, n ));
     }
 
     void insert_dimensions( dimension_type type, unsigned pos, unsigned n=1)
     {
-        m_object = isl_space_insert_dims(m_object,
-                                         (isl_dim_type) type, pos, n);
+        update(isl_space_insert_dims(m_object,
+                                     (isl_dim_type) type, pos, n));
     }
     void drop_dimensions( dimension_type type, unsigned pos, unsigned n=1)
     {
-        m_object = isl_space_drop_dims(m_object,
-                                       (isl_dim_type) type, pos, n);
+        update(isl_space_drop_dims(m_object,
+                                   (isl_dim_type) type, pos, n));
+    }
+
+    // A hash of the dimension counts and tuple identifiers.
+    // Equal spaces have equal hashes.
+    std::size_t hash() const
+    {
+        isl_space * s = get();
+        std::size_t h = isl_space_dim(s, isl_dim_param);
+        if (isl_space_is_params(s) == isl_bool_true)
+            return h;
+
+        bool is_set = isl_space_is_set(s) == isl_bool_true;
+        for (isl_dim_type type : { isl_dim_in, isl_dim_out })
+        {
+            if (is_set && type == isl_dim_in)
+                continue;
+            h = h * 31 + isl_space_dim(s, type);
+            if (isl_space_has_tuple_id(s, type) == isl_bool_true)
+            {
+                isl_id * c_id = isl_space_get_tuple_id(s, type);
+                h = h * 31 + isl_id_get_hash(c_id);
+                isl_id_free(c_id);
+            }
+        }
+        return h;
     }
 
     identifier id( dimension_type type ) const
@@ -254,9 +318,9 @@ public:
     }
     void set_id( dimension_type type, const identifier & id )
     {
-        isl_id *c_id = id.c_id(m_ctx.get());
+        isl_id *c_id = id.c_id(ctx());
         if (c_id)
-            m_object = isl_space_set_tuple_id(get(), (isl_dim_type)type, c_id);
+            update(isl_space_set_tuple_id(get(), (isl_dim_type)type, c_id));
     }
     string name( dimension_type type ) const
     {
@@ -264,14 +328,14 @@ public:
     }
     void set_name( dimension_type type, const string & name )
     {
-        m_object = isl_space_set_tuple_name(m_object,
-                                            (isl_dim_type) type, name.c_str());
+        update(isl_space_set_tuple_name(m_object,
+                                        (isl_dim_type) type, name.c_str()));
     }
     void set_name( dimension_type type, unsigned pos, const string & name )
     {
-        m_object = isl_space_set_dim_name(m_object,
-                                          (isl_dim_type) type,
-                                          pos, name.c_str());
+        update(isl_space_set_dim_name(m_object,
+                                      (isl_dim_type) type,
+                                      pos, name.c_str()));
     }
     bool is_params() const
     {
@@ -292,7 +356,7 @@ public:
 
     space & wrap()
     {
-        m_object = isl_space_wrap(m_object);
+        update(isl_space_wrap(m_object));
         return *this;
     }
 
@@ -302,14 +366,16 @@ public:
     }
 
 private:
-    space( context & ctx, isl_space *space ): object(ctx, space) {}
+    space( const context & ctx, isl_space *space ): object(ctx, space) {}
 
-    void set_identifiers( dimension_type type, const tuple & tup )
+    void set_identifiers( const context & ctx, dimension_type type, const tuple & tup )
     {
         if (!tup.size())
             return;
 
-        set_id(type, tup.id);
+        isl_id * tuple_id = tup.id.c_id(ctx);
+        if (tuple_id)
+            update(isl_space_set_tuple_id(get(), (isl_dim_type)type, tuple_id));
 
         int dim_idx = 0;
         for (const identifier & elem : tup.elements)
@@ -317,8 +383,8 @@ private:
             if (elem.empty())
                 continue;
 
-            isl_id * c_id = isl_id_alloc(m_ctx.get(), elem.name().c_str(), elem.data());
-            m_object = isl_space_set_dim_id(get(), (isl_dim_type)type, dim_idx, c_id);
+            isl_id * c_id = elem.c_id(ctx);
+            update(isl_space_set_dim_id(get(), (isl_dim_type)type, dim_idx, c_id));
             ++dim_idx;
         }
     }
@@ -354,6 +420,151 @@ space operator*(const space &lhs, const space &rhs)
     return product(lhs, rhs);
 }
 
+inline
+bool operator==( const space & lhs, const space & rhs )
+{
+    if (lhs.get() == rhs.get())
+        return true;
+    return checked(isl_space_is_equal(lhs.get(), rhs.get()));
+}
+
+inline
+bool operator!=( const space & lhs, const space & rhs )
+{
+    return !(lhs == rhs);
+}
+
+namespace detail {
+
+// Orders identifiers by name, then by isl object. Takes a and b,
+// either of which may be null for a missing identifier.
+inline
+int compare_ids( isl_id * a, isl_id * b )
+{
+    int cmp = 0;
+    if (a != b)
+    {
+        const char * name_a = a ? isl_id_get_name(a) : nullptr;
+        const char * name_b = b ? isl_id_get_name(b) : nullptr;
+        cmp = std::strcmp(name_a ? name_a : "", name_b ? name_b : "");
+        if (cmp == 0)
+            cmp = std::less<isl_id*>()(a, b) ? -1 : 1;
+    }
+    isl_id_free(a);
+    isl_id_free(b);
+    return cmp;
+}
+
+inline
+isl_id * tuple_id_or_null( isl_space * s, isl_dim_type type )
+{
+    if (isl_space_has_tuple_id(s, type) != isl_bool_true)
+        return nullptr;
+    return isl_space_get_tuple_id(s, type);
+}
+
+// The space wrapped in a tuple, or null.
+inline
+isl_space * nested_space( isl_space * s, isl_dim_type type )
+{
+    if (isl_space_is_set(s) == isl_bool_true)
+    {
+        if (isl_space_is_wrapping(s) != isl_bool_true)
+            return nullptr;
+        return isl_space_unwrap(isl_space_copy(s));
+    }
+    if (type == isl_dim_in)
+    {
+        if (isl_space_domain_is_wrapping(s) != isl_bool_true)
+            return nullptr;
+        return isl_space_unwrap(isl_space_domain(isl_space_copy(s)));
+    }
+    if (isl_space_range_is_wrapping(s) != isl_bool_true)
+        return nullptr;
+    return isl_space_unwrap(isl_space_range(isl_space_copy(s)));
+}
+
+inline
+int compare_tuples( isl_space * a, isl_space * b );
+
+// Compares a tuple of two spaces by what isl_space_is_equal
+// looks at: the dimension count, the identifier and nested spaces.
+inline
+int compare_tuple( isl_space * a, isl_space * b, isl_dim_type type )
+{
+    int cmp = isl_space_dim(a, type) - isl_space_dim(b, type);
+    if (cmp != 0)
+        return cmp;
+
+    cmp = compare_ids(tuple_id_or_null(a, type), tuple_id_or_null(b, type));
+    if (cmp != 0)
+        return cmp;
+
+    isl_space * nested_a = nested_space(a, type);
+    isl_space * nested_b = nested_space(b, type);
+    if (nested_a && nested_b)
+        cmp = compare_tuples(nested_a, nested_b);
+    else
+        cmp = (nested_a != nullptr) - (nested_b != nullptr);
+    isl_space_free(nested_a);
+    isl_space_free(nested_b);
+    return cmp;
+}
+
+// Compares all tuples of two spaces, but not their parameters.
+inline
+int compare_tuples( isl_space * a, isl_space * b )
+{
+    int params_a = isl_space_is_params(a) == isl_bool_true;
+    int params_b = isl_space_is_params(b) == isl_bool_true;
+    if (params_a || params_b)
+        return params_a - params_b;
+
+    int set_a = isl_space_is_set(a) == isl_bool_true;
+    int set_b = isl_space_is_set(b) == isl_bool_true;
+    if (set_a != set_b)
+        return set_a - set_b;
+
+    if (!set_a)
+    {
+        int cmp = compare_tuple(a, b, isl_dim_in);
+        if (cmp != 0)
+            return cmp;
+    }
+    return compare_tuple(a, b, isl_dim_out);
+}
+
+}
+
+// Orders spaces by their parameters and then their tuples, comparing
+// what isl_space_is_equal compares, so equal spaces are equivalent.
+inline
+bool operator<( const space & lhs, const space & rhs )
+{
+    isl_space * a = lhs.get();
+    isl_space * b = rhs.get();
+    if (a == b)
+        return false;
+
+    int cmp = isl_space_dim(a, isl_dim_param) - isl_space_dim(b, isl_dim_param);
+    if (cmp != 0)
+        return cmp < 0;
+
+    int n_params = isl_space_dim(a, isl_dim_param);
+    for (int i = 0; i < n_params; ++i)
+    {
+        isl_id * id_a = isl_space_has_dim_id(a, isl_dim_param, i) == isl_bool_true ?
+                    isl_space_get_dim_id(a, isl_dim_param, i) : nullptr;
+        isl_id * id_b = isl_space_has_dim_id(b, isl_dim_param, i) == isl_bool_true ?
+                    isl_space_get_dim_id(b, isl_dim_param, i) : nullptr;
+        cmp = detail::compare_ids(id_a, id_b);
+        if (cmp != 0)
+            return cmp < 0;
+    }
+
+    return detail::compare_tuples(a, b) < 0;
+}
+
 template<>
 struct object_behavior<isl_local_space>
 {
@@ -435,4 +646,20 @@ public:
 
 }
 
+namespace std {
+
+template<>
+struct hash<isl::identifier>
+{
+    size_t operator()( const isl::identifier & id ) const { return id.hash(); }
+};
+
+template<>
+struct hash<isl::space>
+{
+    size_t operator()( const isl::space & s ) const { return s.hash(); }
+};
+
+}
+
 #endif // ISL_CPP_SPACE_INCLUDED
@@ -0,0 +1,136 @@
+/*
+isl-cpp: C++ bindings to the ISL (Integer Set Library)
+
+Copyright (C) 2014  Jakob Leben <jakob.leben@gmail.com>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "space_cache.hpp"
+
+namespace isl {
+
+namespace {
+
+std::size_t hash_of( const tuple & t )
+{
+    std::size_t h = t.id.hash() * 31 + t.size();
+    for (const identifier & elem : t.elements)
+        h = h * 31 + elem.hash();
+    return h;
+}
+
+bool equal( const tuple & a, const tuple & b )
+{
+    return a.id == b.id && a.elements == b.elements;
+}
+
+}
+
+// Entries hold plain isl spaces, since a space object would keep
+// alive the context that owns the cache.
+struct space_cache::entry
+{
+    kind k;
+    tuple params;
+    tuple in;
+    tuple out;
+    isl_space * s;
+};
+
+struct space_cache::table
+{
+    ~table() { clear(); }
+
+    void clear()
+    {
+        for (auto & e : entries)
+            isl_space_free(e.second.s);
+        entries.clear();
+    }
+
+    std::unordered_multimap<std::size_t, entry> entries;
+};
+
+space_cache::space_cache(): d(new table) {}
+
+space_cache::~space_cache() {}
+
+template <typename F>
+space space_cache::find_or_build( const context & ctx, kind k, const tuple & params,
+                                  const tuple & in, const tuple & out, F build )
+{
+    std::size_t hash = k;
+    hash = hash * 31 + hash_of(params);
+    hash = hash * 31 + hash_of(in);
+    hash = hash * 31 + hash_of(out);
+
+    auto range = d->entries.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        const entry & e = it->second;
+        if (e.k == k && equal(e.params, params) &&
+                equal(e.in, in) && equal(e.out, out))
+            return space(ctx, isl_space_copy(e.s));
+    }
+
+    space s = build();
+    entry e = { k, params, in, out, s.copy() };
+    d->entries.emplace(hash, e);
+    return s;
+}
+
+space space_cache::get( const context & ctx, const parameter_tuple & params )
+{
+    return find_or_build(ctx, parameter_space, params, tuple(), tuple(),
+                         [&]{ return space(ctx, params); });
+}
+
+space space_cache::get( const context & ctx, const set_tuple & vars )
+{
+    return find_or_build(ctx, set_space, tuple(), tuple(), vars,
+                         [&]{ return space(ctx, vars); });
+}
+
+space space_cache::get( const context & ctx, const tuple & params, const tuple & vars )
+{
+    return find_or_build(ctx, set_space, params, tuple(), vars,
+                         [&]{ return space(ctx, params, vars); });
+}
+
+space space_cache::get( const context & ctx, const input_tuple & in, const output_tuple & out )
+{
+    return find_or_build(ctx, map_space, tuple(), in, out,
+                         [&]{ return space(ctx, in, out); });
+}
+
+space space_cache::get( const context & ctx, const tuple & params,
+                        const tuple & in, const tuple & out )
+{
+    return find_or_build(ctx, map_space, params, in, out,
+                         [&]{ return space(ctx, params, in, out); });
+}
+
+std::size_t space_cache::size() const
+{
+    return d->entries.size();
+}
+
+void space_cache::clear()
+{
+    d->clear();
+}
+
+}
@@ -0,0 +1,128 @@
+/*
+isl-cpp: C++ bindings to the ISL (Integer Set Library)
+
+Copyright (C) 2014  Jakob Leben <jakob.leben@gmail.com>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef ISL_CPP_SPACE_CACHE_INCLUDED
+#define ISL_CPP_SPACE_CACHE_INCLUDED
+
+#include "context.hpp"
+#include "space.hpp"
+
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <cstddef>
+
+namespace isl {
+
+// Spaces built from tuples, kept per context and keyed by the
+// layout of the tuples: their names, sizes and element names.
+// Building a space with the same layout again returns the
+// same isl space instead of allocating a new one.
+
+class space_cache
+{
+public:
+    space_cache();
+    ~space_cache();
+
+    space_cache( const space_cache & ) = delete;
+    space_cache & operator=( const space_cache & ) = delete;
+
+    space get( const context & ctx, const parameter_tuple & params );
+    space get( const context & ctx, const set_tuple & vars );
+    space get( const context & ctx, const tuple & params, const tuple & vars );
+    space get( const context & ctx, const input_tuple & in, const output_tuple & out );
+    space get( const context & ctx, const tuple & params,
+               const tuple & in, const tuple & out );
+
+    std::size_t size() const;
+    void clear();
+
+private:
+    enum kind { parameter_space, set_space, map_space };
+
+    template <typename F>
+    space find_or_build( const context & ctx, kind k, const tuple & params,
+                         const tuple & in, const tuple & out, F build );
+
+    struct entry;
+    struct table;
+    std::unique_ptr<table> d;
+};
+
+// Returns the space with the given tuples from the space cache
+// of ctx, building it only the first time.
+template <typename... Tuples> inline
+space shared_space( const context & ctx, const Tuples & ... tuples )
+{
+    return ctx.spaces().get(ctx, tuples...);
+}
+
+// Spaces looked up by a key of the user's choice,
+// so hot code does not need to rebuild them.
+
+template <typename Key, typename Hash = std::hash<Key>>
+class space_registry
+{
+public:
+    const space & insert( const Key & key, const space & s )
+    {
+        auto result = m_spaces.emplace(key, s);
+        if (!result.second)
+            result.first->second = s;
+        return result.first->second;
+    }
+
+    // Returns null if there is no space for the key.
+    const space * find( const Key & key ) const
+    {
+        auto it = m_spaces.find(key);
+        return it != m_spaces.end() ? &it->second : nullptr;
+    }
+
+    const space & at( const Key & key ) const
+    {
+        auto it = m_spaces.find(key);
+        if (it == m_spaces.end())
+            throw error("No space registered for key.");
+        return it->second;
+    }
+
+    // Returns the space for the key, calling build to make it
+    // if there is none yet.
+    template <typename F>
+    const space & get( const Key & key, F build )
+    {
+        auto it = m_spaces.find(key);
+        if (it != m_spaces.end())
+            return it->second;
+        return m_spaces.emplace(key, build()).first->second;
+    }
+
+    std::size_t size() const { return m_spaces.size(); }
+    void clear() { m_spaces.clear(); }
+
+private:
+    std::unordered_map<Key, space, Hash> m_spaces;
+};
+
+}
+
+#endif // ISL_CPP_SPACE_CACHE_INCLUDED
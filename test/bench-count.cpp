@@ -0,0 +1,56 @@
+#include "../context.hpp"
+#include "../set.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+using namespace isl;
+using namespace std;
+
+// Compares counting the points of a set by enumerating them,
+// by count() and by count_upto() with a small limit.
+
+typedef chrono::steady_clock bench_clock;
+
+static double elapsed_ms(bench_clock::time_point start)
+{
+    return chrono::duration<double, milli>(bench_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    int n = 200;
+    if (argc > 1)
+        n = atoi(argv[1]);
+
+    context ctx;
+    ctx.set_error_action(context::abort_on_error);
+
+    set s(ctx, "[n] -> { [i, j, k] : 0 <= i < n and 0 <= j < n and 0 <= k <= i + j }");
+    s = isl_set_fix_si(s.release(), isl_dim_param, 0, n);
+    s = isl_set_project_out(s.release(), isl_dim_param, 0, 1);
+
+    auto start = bench_clock::now();
+    long enumerated = 0;
+    s.for_each_point([&](const point &){
+        ++enumerated;
+        return true;
+    });
+    double enumerate_ms = elapsed_ms(start);
+
+    start = bench_clock::now();
+    value counted = s.count();
+    double count_ms = elapsed_ms(start);
+
+    start = bench_clock::now();
+    int64_t at_least = s.count_upto(1000);
+    double upto_ms = elapsed_ms(start);
+
+    cout << enumerated << " points:" << endl
+         << "enumerate " << enumerate_ms << " ms, "
+         << "count " << count_ms << " ms (" << counted.numerator() << "), "
+         << "count_upto 1000 " << upto_ms << " ms (" << at_least << ")" << endl;
+
+    return 0;
+}
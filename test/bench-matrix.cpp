@@ -0,0 +1,104 @@
+#include "../context.hpp"
+#include "../matrix.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+using namespace isl;
+using namespace std;
+
+// Compares the native block operations on matrix against
+// copying the elements one isl_val at a time.
+
+typedef chrono::steady_clock bench_clock;
+
+static double elapsed_ms(bench_clock::time_point start)
+{
+    return chrono::duration<double, milli>(bench_clock::now() - start).count();
+}
+
+static matrix drop_column_per_element(const matrix & m, int col)
+{
+    int n_rows = m.row_count();
+    int n_cols = m.column_count() - 1;
+
+    isl_mat * result = isl_mat_alloc(m.ctx().get(), n_rows, n_cols);
+    for (int r = 0; r < n_rows; ++r)
+    {
+        for (int c = 0; c < col; ++c)
+            result = isl_mat_set_element_val(result, r, c, isl_mat_get_element_val(m.get(), r, c));
+        for (int c = col; c < n_cols; ++c)
+            result = isl_mat_set_element_val(result, r, c, isl_mat_get_element_val(m.get(), r, c+1));
+    }
+    return result;
+}
+
+static matrix concat_per_element(const matrix & a, const matrix & b)
+{
+    matrix result(a.ctx(), a.row_count() + b.row_count(), a.column_count());
+    for (int row = 0; row < a.row_count(); ++row)
+        for (int col = 0; col < a.column_count(); ++col)
+            result(row, col) = a(row, col).value();
+    for (int row = 0; row < b.row_count(); ++row)
+        for (int col = 0; col < b.column_count(); ++col)
+            result(a.row_count() + row, col) = b(row, col).value();
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    int rows = 1000;
+    int cols = 100;
+    int repeat = 10;
+    if (argc > 2)
+    {
+        rows = atoi(argv[1]);
+        cols = atoi(argv[2]);
+    }
+
+    context ctx;
+    ctx.set_error_action(context::abort_on_error);
+
+    matrix m(ctx, rows, cols);
+    for (int r = 0; r < rows; ++r)
+        for (int c = 0; c < cols; ++c)
+            m(r, c) = r * cols + c;
+
+    auto start = bench_clock::now();
+    for (int i = 0; i < repeat; ++i)
+        drop_column_per_element(m, cols / 2);
+    double drop_old_ms = elapsed_ms(start) / repeat;
+
+    start = bench_clock::now();
+    for (int i = 0; i < repeat; ++i)
+    {
+        matrix d = m;
+        d.drop_column(cols / 2);
+    }
+    double drop_new_ms = elapsed_ms(start) / repeat;
+
+    start = bench_clock::now();
+    for (int i = 0; i < repeat; ++i)
+        concat_per_element(m, m);
+    double concat_old_ms = elapsed_ms(start) / repeat;
+
+    start = bench_clock::now();
+    for (int i = 0; i < repeat; ++i)
+        matrix::concat_vertical(m, m);
+    double concat_new_ms = elapsed_ms(start) / repeat;
+
+    start = bench_clock::now();
+    for (int i = 0; i < repeat; ++i)
+        m.submatrix(rows / 4, cols / 4, rows / 2, cols / 2);
+    double sub_ms = elapsed_ms(start) / repeat;
+
+    cout << rows << "x" << cols << ":" << endl
+         << "drop column: per element " << drop_old_ms << " ms, "
+         << "native " << drop_new_ms << " ms" << endl
+         << "concatenate: per element " << concat_old_ms << " ms, "
+         << "native " << concat_new_ms << " ms" << endl
+         << "submatrix: native " << sub_ms << " ms" << endl;
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include "../context.hpp"
+#include "../set.hpp"
+#include "../map.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace isl;
+using namespace std;
+
+// Compares building unions from const lvalue operands, where every
+// step copies the accumulated union and isl has to clone it before
+// modifying, with consuming the accumulated union through rvalues.
+
+typedef chrono::steady_clock bench_clock;
+
+static double elapsed_ms(bench_clock::time_point start)
+{
+    return chrono::duration<double, milli>(bench_clock::now() - start).count();
+}
+
+static void bench_union_set(context & ctx, int count)
+{
+    vector<set> sets;
+    for (int i = 0; i < count; ++i)
+    {
+        ostringstream text;
+        text << "{ S" << i << "[a,b] : 0 <= a < 10 and 0 <= b < a }";
+        sets.emplace_back(ctx, text.str());
+    }
+
+    auto start = bench_clock::now();
+    {
+        union_set u(ctx);
+        for (const auto & s : sets)
+        {
+            const union_set & old_u = u;
+            u = old_u | s;
+        }
+    }
+    double copy_ms = elapsed_ms(start);
+
+    start = bench_clock::now();
+    {
+        union_set u(ctx);
+        for (const auto & s : sets)
+            u |= s;
+    }
+    double move_ms = elapsed_ms(start);
+
+    cout << "union_set x " << count << ": "
+         << "copy " << copy_ms << " ms, "
+         << "move " << move_ms << " ms" << endl;
+}
+
+static void bench_union_map(context & ctx, int count)
+{
+    vector<map> maps;
+    for (int i = 0; i < count; ++i)
+    {
+        ostringstream text;
+        text << "{ S" << i << "[a,b] -> T" << i << "[a+b] : 0 <= a,b < 10 }";
+        maps.emplace_back(ctx, text.str());
+    }
+
+    auto start = bench_clock::now();
+    {
+        union_map u(ctx);
+        for (const auto & m : maps)
+        {
+            const union_map & old_u = u;
+            u = old_u | m;
+        }
+    }
+    double copy_ms = elapsed_ms(start);
+
+    start = bench_clock::now();
+    {
+        union_map u(ctx);
+        for (const auto & m : maps)
+            u |= m;
+    }
+    double move_ms = elapsed_ms(start);
+
+    cout << "union_map x " << count << ": "
+         << "copy " << copy_ms << " ms, "
+         << "move " << move_ms << " ms" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    int count = 2000;
+    if (argc > 1)
+        count = atoi(argv[1]);
+
+    context ctx;
+    ctx.set_error_action(context::abort_on_error);
+
+    bench_union_set(ctx, count);
+    bench_union_map(ctx, count);
+
+    return 0;
+}
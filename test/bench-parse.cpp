@@ -0,0 +1,58 @@
+#include "../context.hpp"
+#include "../set.hpp"
+#include "../map.hpp"
+#include "../parse_cache.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+using namespace isl;
+using namespace std;
+
+// Compares building the same set and map literals over and over
+// through the constructors against going through the parse cache.
+
+typedef chrono::steady_clock bench_clock;
+
+static double elapsed_ms(bench_clock::time_point start)
+{
+    return chrono::duration<double, milli>(bench_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    int count = 100000;
+    if (argc > 1)
+        count = atoi(argv[1]);
+
+    context ctx;
+    ctx.set_error_action(context::abort_on_error);
+
+    const char * set_text = "[n] -> { S[i, j] : 0 <= i < n and 0 <= j <= i }";
+    const char * map_text = "[n] -> { S[i, j] -> T[j, i] : 0 <= i < n and (i + j) mod 2 = 0 }";
+
+    auto start = bench_clock::now();
+    for (int i = 0; i < count; ++i)
+    {
+        set s(ctx, set_text);
+        map m(ctx, map_text);
+    }
+    double constructor_ms = elapsed_ms(start);
+
+    start = bench_clock::now();
+    for (int i = 0; i < count; ++i)
+    {
+        set s = parse<set>(ctx, set_text);
+        map m = parse<map>(ctx, map_text);
+    }
+    double cache_ms = elapsed_ms(start);
+
+    const parse_cache::statistics & stats = ctx.parsed_texts().stats();
+    cout << count << " times:" << endl
+         << "constructors " << constructor_ms << " ms, "
+         << "parse cache " << cache_ms << " ms" << endl
+         << "hit rate " << stats.hit_rate() << endl;
+
+    return 0;
+}
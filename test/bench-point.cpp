@@ -0,0 +1,106 @@
+#include "../context.hpp"
+#include "../set.hpp"
+#include "../point.hpp"
+#include "../point_cursor.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace isl;
+using namespace std;
+
+// Compares reading point coordinates in bulk against
+// reading them one isl::value at a time, and enumerating the points
+// of a set one at a time against enumerating them in batches and
+// paging through them with a cursor.
+
+typedef chrono::steady_clock bench_clock;
+
+static double elapsed_ms(bench_clock::time_point start)
+{
+    return chrono::duration<double, milli>(bench_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    int repeat = 1000000;
+    if (argc > 1)
+        repeat = atoi(argv[1]);
+
+    context ctx;
+    ctx.set_error_action(context::abort_on_error);
+
+    set s(ctx, "{ [a, b, c, d, e, f, g, h] : a = 1 and b = -2 and c = 3 and d = -4 and "
+               "e = 5 and f = -6 and g = 7 and h = -8 }");
+    point pt = s.single_point();
+    int dims = pt.dimension(space::variable);
+
+    int64_t sum = 0;
+
+    auto start = bench_clock::now();
+    for (int i = 0; i < repeat; ++i)
+        for (int d = 0; d < dims; ++d)
+            sum += pt(space::variable, d).numerator();
+    double value_ms = elapsed_ms(start);
+
+    vector<int64_t> coords;
+    start = bench_clock::now();
+    for (int i = 0; i < repeat; ++i)
+    {
+        pt.coordinates(coords);
+        for (int64_t x : coords)
+            sum += x;
+    }
+    double bulk_ms = elapsed_ms(start);
+
+    cout << repeat << " x " << dims << " coordinates:" << endl
+         << "per value " << value_ms << " ms, "
+         << "bulk " << bulk_ms << " ms"
+         << " (" << sum << ")" << endl;
+
+    set domain(ctx, "{ [i, j] : 0 <= i < 1000 and 0 <= j <= i }");
+    size_t points = 0;
+
+    start = bench_clock::now();
+    domain.for_each_point([&](const point & p){
+        p.coordinates(coords);
+        sum += coords[0] + coords[1];
+        ++points;
+        return true;
+    });
+    double each_ms = elapsed_ms(start);
+
+    start = bench_clock::now();
+    domain.for_each_point_batch([&](const point_batch & batch){
+        const int64_t * i = batch.variable(0);
+        const int64_t * j = batch.variable(1);
+        for (size_t k = 0; k < batch.size(); ++k)
+            sum += i[k] + j[k];
+        return true;
+    });
+    double batch_ms = elapsed_ms(start);
+
+    start = bench_clock::now();
+    {
+        point_cursor cursor(domain);
+        point_batch page(2, 4096);
+        while (cursor.next_page(page))
+        {
+            const int64_t * i = page.variable(0);
+            const int64_t * j = page.variable(1);
+            for (size_t k = 0; k < page.size(); ++k)
+                sum += i[k] + j[k];
+        }
+    }
+    double cursor_ms = elapsed_ms(start);
+
+    cout << points << " points:" << endl
+         << "for_each_point " << each_ms << " ms, "
+         << "for_each_point_batch " << batch_ms << " ms, "
+         << "point_cursor pages " << cursor_ms << " ms"
+         << " (" << sum << ")" << endl;
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include "../context.hpp"
+#include "../map.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace isl;
+using namespace std;
+
+// Compares printing a large union map with a flush after each line
+// against printing it with print_all.
+
+typedef chrono::steady_clock bench_clock;
+
+static double elapsed_ms(bench_clock::time_point start)
+{
+    return chrono::duration<double, milli>(bench_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    int count = 100000;
+    const char * path = "/dev/null";
+    if (argc > 1)
+        count = atoi(argv[1]);
+    if (argc > 2)
+        path = argv[2];
+
+    context ctx;
+    ctx.set_error_action(context::abort_on_error);
+
+    ostringstream text;
+    text << "{ ";
+    for (int i = 0; i < count; ++i)
+        text << (i ? "; " : "") << "S" << i << "[i, j] -> T[i + j, " << i << "] : 0 <= i, j < 100";
+    text << " }";
+    union_map maps(ctx, text.str());
+
+    FILE * file = fopen(path, "w");
+
+    auto start = bench_clock::now();
+    {
+        printer p(ctx, file);
+        maps.for_each([&](const map & m){
+            p.print(m);
+            p.end_line();
+            p.flush();
+            return true;
+        });
+    }
+    double per_line_ms = elapsed_ms(start);
+
+    start = bench_clock::now();
+    {
+        printer p(ctx, file);
+        p.print_all(maps);
+    }
+    double file_ms = elapsed_ms(start);
+
+    fclose(file);
+
+    ofstream stream(path);
+    start = bench_clock::now();
+    {
+        printer p(ctx, stream);
+        p.print_all(maps);
+    }
+    double stream_ms = elapsed_ms(start);
+
+    cout << count << " maps:" << endl
+         << "flush per line " << per_line_ms << " ms, "
+         << "print_all to file " << file_ms << " ms, "
+         << "print_all to stream " << stream_ms << " ms" << endl;
+
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include "../context.hpp"
+#include "../map.hpp"
+#include "../reader.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace isl;
+using namespace std;
+
+// Compares loading a large union map file by parsing its whole text
+// against reading it element by element from a mapped file.
+
+typedef chrono::steady_clock bench_clock;
+
+static double elapsed_ms(bench_clock::time_point start)
+{
+    return chrono::duration<double, milli>(bench_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    int count = 20000;
+    const char * path = "bench-reader.txt";
+    if (argc > 1)
+        count = atoi(argv[1]);
+    if (argc > 2)
+        path = argv[2];
+
+    context ctx;
+    ctx.set_error_action(context::abort_on_error);
+
+    {
+        ofstream file(path);
+        file << "[n] -> { ";
+        for (int i = 0; i < count; ++i)
+            file << (i ? ";\n" : "") << "S" << i << "[i, j] -> T[i + j, floor(i / 3)] : "
+                 << "0 <= i < n and 0 <= j < " << i + 1 << " and (i + j) mod 4 = 1";
+        file << " }\n";
+    }
+
+    auto start = bench_clock::now();
+    ifstream file(path);
+    stringstream text;
+    text << file.rdbuf();
+    union_map from_text(ctx, text.str());
+    double text_ms = elapsed_ms(start);
+
+    start = bench_clock::now();
+    mapped_file mapped(path);
+    union_map from_reader(ctx);
+    union_reader(ctx, mapped).read_into(from_reader);
+    double reader_ms = elapsed_ms(start);
+
+    bool same = isl_union_map_is_equal(from_text.get(), from_reader.get()) == isl_bool_true;
+
+    cout << count << " maps, " << mapped.size() << " bytes:" << endl
+         << "whole text " << text_ms << " ms, "
+         << "union_reader " << reader_ms << " ms" << endl
+         << "same: " << (same ? "yes" : "no") << endl;
+
+    remove(path);
+    return 0;
+}
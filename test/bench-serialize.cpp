@@ -0,0 +1,63 @@
+#include "../context.hpp"
+#include "../map.hpp"
+#include "../serialize.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+using namespace isl;
+using namespace std;
+
+// Compares loading a large union map from text
+// against loading it from the binary format.
+
+typedef chrono::steady_clock bench_clock;
+
+static double elapsed_ms(bench_clock::time_point start)
+{
+    return chrono::duration<double, milli>(bench_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    int count = 20000;
+    if (argc > 1)
+        count = atoi(argv[1]);
+
+    context ctx;
+    ctx.set_error_action(context::abort_on_error);
+
+    ostringstream source;
+    source << "[n] -> { ";
+    for (int i = 0; i < count; ++i)
+        source << (i ? "; " : "") << "S" << i << "[i, j] -> T[i + j, floor(i / 3)] : "
+               << "0 <= i < n and 0 <= j < " << i + 1 << " and (i + j) mod 4 = 1";
+    source << " }";
+    union_map maps(ctx, source.str());
+
+    printer p(ctx, printer::to_string);
+    p.print(maps);
+    string text = p.str();
+
+    vector<char> binary;
+    serialize(maps, binary);
+
+    auto start = bench_clock::now();
+    union_map from_text(ctx, text);
+    double text_ms = elapsed_ms(start);
+
+    start = bench_clock::now();
+    union_map from_binary = deserialize<union_map>(ctx, binary);
+    double binary_ms = elapsed_ms(start);
+
+    bool same = isl_union_map_is_equal(from_text.get(), from_binary.get()) == isl_bool_true;
+
+    cout << count << " maps:" << endl
+         << "text " << text.size() << " bytes, parsed in " << text_ms << " ms" << endl
+         << "binary " << binary.size() << " bytes, read in " << binary_ms << " ms" << endl
+         << "same: " << (same ? "yes" : "no") << endl;
+
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include "../context.hpp"
+#include "../set.hpp"
+#include "../map.hpp"
+#include "../transfer.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+using namespace isl;
+using namespace std;
+
+// Compares moving a union_map to another context with isl::transfer
+// against printing it to text and parsing it in the other context.
+
+typedef chrono::steady_clock bench_clock;
+
+static double elapsed_ms(bench_clock::time_point start)
+{
+    return chrono::duration<double, milli>(bench_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    int count = 1000;
+    int repeat = 10;
+    if (argc > 1)
+        count = atoi(argv[1]);
+
+    context source;
+    context target;
+    source.set_error_action(context::abort_on_error);
+    target.set_error_action(context::abort_on_error);
+
+    union_map u(source);
+    for (int i = 0; i < count; ++i)
+    {
+        ostringstream text;
+        text << "[n] -> { S" << i << "[a,b] -> T" << i << "[a+b, a-b] : "
+             << "0 <= a < n and 0 <= b < a and exists k : a = 3k + b }";
+        u |= map(source, text.str());
+    }
+
+    auto start = bench_clock::now();
+    for (int r = 0; r < repeat; ++r)
+    {
+        char *text = isl_union_map_to_str(u.get());
+        union_map copy(isl_union_map_read_from_str(target.get(), text));
+        free(text);
+    }
+    double text_ms = elapsed_ms(start) / repeat;
+
+    start = bench_clock::now();
+    for (int r = 0; r < repeat; ++r)
+    {
+        union_map copy = transfer(u, target);
+    }
+    double transfer_ms = elapsed_ms(start) / repeat;
+
+    cout << "union_map x " << count << ": "
+         << "text " << text_ms << " ms, "
+         << "transfer " << transfer_ms << " ms" << endl;
+
+    return 0;
+}
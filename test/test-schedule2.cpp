@@ -1,5 +1,6 @@
 #include "set.hpp"
 #include "map.hpp"
+#include "integer.hpp"
 #include <isl/schedule.h>
 #include <isl/ast_build.h>
 #include <cstdio>
@@ -9,23 +10,6 @@
 
 using namespace std;
 
-int gcd(int a, int b)
-{
-    for (;;)
-    {
-        if (a == 0) return b;
-        b %= a;
-        if (b == 0) return a;
-        a %= b;
-    }
-}
-
-int lcm(int a, int b)
-{
-    int div = gcd(a, b);
-    return div ? (a / div * b) : 0;
-}
-
 int main()
 {
     isl::context ctx;
@@ -100,18 +84,22 @@ int main()
 
                 auto eq = bm.equalities_matrix();
                 int rows = eq.row_count();
+                int cols = eq.column_count();
+
+                vector<int64_t> coefs;
+                eq.to_int64(coefs);
 
                 int flow_dim = out_dims;
                 int k = 0;
 
                 for (int r = 0; r < rows; ++r)
                 {
-                    int in0_k = eq(r, 0).value().integer();
+                    int in0_k = coefs[r * cols];
                     if (in0_k)
                     {
                         for (int out = 0; out < out_dims; ++out)
                         {
-                            int out_k = eq(r, out + in_dims).value().integer();
+                            int out_k = coefs[r * cols + out + in_dims];
                             if (out_k)
                             {
                                 if (out < flow_dim)
@@ -137,7 +125,10 @@ int main()
             return true;
         });
 
-        common_period = std::accumulate(ks.begin(), ks.end(), 1, lcm);
+        integer period(ctx, 1);
+        for (int k : ks)
+            period = lcm(period, integer(ctx, k));
+        common_period = period.to_int64();
 
         // Offset
 
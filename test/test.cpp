@@ -4,10 +4,28 @@
 #include "../map.hpp"
 #include "../expression.hpp"
 #include "../matrix.hpp"
+#include "../small_matrix.hpp"
+#include "../integer.hpp"
 #include "../utility.hpp"
 #include "../printer.hpp"
+#include "../transfer.hpp"
+#include "../parallel.hpp"
+#include "../intern.hpp"
+#include "../space_cache.hpp"
+#include "../typed.hpp"
+#include "../serialize.hpp"
+#include "../reader.hpp"
+#include "../parse_cache.hpp"
+#include "../point_cursor.hpp"
 
 #include <iostream>
+#include <algorithm>
+#include <unordered_map>
+#include <atomic>
+#include <sstream>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 using namespace isl;
 using namespace std;
@@ -48,6 +66,7 @@ void test_set(context & ctx, printer &p)
     {
         //union_set u(ctx, "{X[a,b]}; {Y[a,b]}");
         //BUG? isl_union_set_read_from_str only reads the first union element!
+        // union_reader reads all of them, see test_union_reader.
 
         union_set a(ctx, "{X[a,b]}");
         union_set b(ctx, "{Y[a,b]}");
@@ -222,13 +241,13 @@ void test_dataflow_counts(context & ctx, printer &p)
     int b_col = 1;
     int c_col = 2;
 
-    matrix flow(ctx, 2, 3, 0);
+    small_matrix flow(2, 3);
     flow(0,a_col) = 2;
     flow(0,b_col) = -1;
     flow(1,b_col) = 3;
     flow(1,c_col ) = -2;
 
-    matrix steady_counts = flow.nullspace();
+    matrix steady_counts = right_kernel(flow, ctx);
     cout << "Steady:" << endl;
     print(steady_counts);
 
@@ -278,6 +297,947 @@ void test_dataflow_counts(context & ctx, printer &p)
     p.print(optimum_point); cout << endl;
 }
 
+void test_threads()
+{
+    cout << "-- Testing per-thread contexts --" << endl;
+
+    const int thread_count = 4;
+    vector<string> results(thread_count);
+    vector<thread> threads;
+
+    for (int t = 0; t < thread_count; ++t)
+    {
+        threads.emplace_back([t, &results]()
+        {
+            context & ctx = context::for_this_thread();
+            ctx.set_error_action(context::abort_on_error);
+
+            union_set u(ctx);
+            for (int i = 0; i <= t; ++i)
+            {
+                ostringstream text;
+                text << "{ S" << i << "[a] : 0 <= a < " << (t + 1) << " }";
+                u |= set(ctx, text.str());
+            }
+
+            ostringstream result;
+            result << "thread " << t << ": ";
+            u.for_each([&](const set & s){
+                result << s.name() << " ";
+                return true;
+            });
+            results[t] = result.str();
+        });
+    }
+
+    for (auto & t : threads)
+        t.join();
+
+    for (const auto & r : results)
+        cout << r << endl;
+}
+
+void test_transfer(context & ctx, printer &p)
+{
+    cout << "-- Testing transfer between contexts --" << endl;
+
+    context other;
+    printer other_p(other);
+
+    {
+        set s(ctx, "[n] -> { A[i,j] : 0 <= i < n and 0 <= j <= i and"
+                   " exists k : i = 2k + j; A[i,j] : i > 5 and j = 0 }");
+        set t = transfer(s, other);
+        cout << "set: "; other_p.print(t); cout << endl;
+        cout << "round trip equal: " << (transfer(t, ctx) == s) << endl;
+    }
+    {
+        map m(ctx, "{ [A[i] -> B[j]] -> C[k] : k = i + j and 0 <= i,j < 10 }");
+        map t = transfer(m, other);
+        cout << "map: "; other_p.print(t); cout << endl;
+        map back = transfer(t, ctx);
+        cout << "round trip equal: "
+             << (back.is_subset_of(m) && m.is_subset_of(back)) << endl;
+    }
+    {
+        union_map u(ctx, "{ X[a] -> Y[a+1] : a >= 0; Y[b] -> Z[2b] }");
+        union_map t = transfer(u, other);
+        cout << "union_map: "; other_p.print(t); cout << endl;
+    }
+    {
+        space s(ctx, isl::tuple(), isl::tuple("A", 2));
+        auto e = floor((s.var(0) * 3 + s.var(1)) / 4) + 1;
+        expression t = transfer(e, other);
+        cout << "expression: "; other_p.print(t); cout << endl;
+    }
+}
+
+void test_parallel(context & ctx, printer &p)
+{
+    cout << "-- Testing parallel union traversal --" << endl;
+
+    worker_pool pool(3);
+
+    union_map u(ctx, "{ A[i] -> B[j] : 0 <= j < i < 10;"
+                     "  B[i] -> C[j] : 0 <= i,j < 5 and j > i;"
+                     "  C[i] -> D[j] : j = 2i;"
+                     "  D[i] -> E[j] : 0 <= j <= i }");
+
+    std::atomic<int> count(0);
+    u.parallel_for_each(pool, [&](const map & m){
+        if (!m.is_empty())
+            ++count;
+    });
+    cout << "non-empty components: " << count << endl;
+
+    union_map lexmin = u.parallel_transform(pool, [](const map & m){
+        return m.lex_minimum();
+    });
+    cout << "lexmin: "; p.print(lexmin); cout << endl;
+    cout << "equal to serial: "
+         << (lexmin.is_subset_of(u.lex_minimum()) &&
+             u.lex_minimum().is_subset_of(lexmin)) << endl;
+}
+
+void test_budget(context & ctx, printer &p)
+{
+    cout << "-- Testing operation budget --" << endl;
+
+    set s(ctx, "{ [i,j,k] : 0 <= i,j,k < 100 and i + j + k = 50 and"
+               " exists a : i = 3a + k }");
+
+    try
+    {
+        context::budget_scope budget(ctx, 10);
+        set m = s.lex_minimum();
+        cout << "lexmin within budget: "; p.print(m); cout << endl;
+    }
+    catch (budget_exceeded &)
+    {
+        cout << "lexmin over budget" << endl;
+    }
+
+    {
+        context::budget_scope budget(ctx, 100000);
+        set m = s.lex_minimum();
+        cout << "lexmin within budget: "; p.print(m); cout << endl;
+    }
+
+    {
+        context::budget_scope deadline(ctx, std::chrono::seconds(10));
+        cout << "empty within deadline: " << s.is_empty() << endl;
+    }
+
+    {
+        context::budget_scope budget(ctx, 100000);
+        set t = s;
+        try
+        {
+            t.project_out_dimensions(space::variable, 5);
+            cout << "bad projection: no error" << endl;
+        }
+        catch (error &)
+        {
+            cout << "bad projection: error" << endl;
+        }
+        cout << "empty after error: " << s.is_empty() << endl;
+    }
+
+    int inner_scopes = 0;
+    try
+    {
+        context::budget_scope outer(ctx, 1000);
+        for (; inner_scopes < 1000; ++inner_scopes)
+        {
+            context::budget_scope inner(ctx, 100000);
+            set m = s.lex_minimum();
+        }
+        cout << "nested: outer budget not enforced" << endl;
+    }
+    catch (budget_exceeded &)
+    {
+        cout << "nested: stopped by outer budget: " << (inner_scopes < 1000) << endl;
+    }
+
+    {
+        context::budget_scope outer(ctx, 100000);
+        try
+        {
+            context::budget_scope inner(ctx, 10);
+            set m = s.lex_minimum();
+            cout << "nested: inner within budget" << endl;
+        }
+        catch (budget_exceeded &)
+        {
+            cout << "nested: inner over budget" << endl;
+        }
+        set m = s.lex_minimum();
+        cout << "nested: outer goes on: "; p.print(m); cout << endl;
+    }
+}
+
+void test_result_cache()
+{
+    cout << "-- Testing result cache --" << endl;
+
+    context ctx;
+    ctx.enable_result_cache();
+    printer p(ctx);
+
+    auto print_stats = [&]()
+    {
+        const result_cache::statistics & stats = ctx.cache()->stats();
+        cout << "hits = " << stats.hits << ", misses = " << stats.misses
+             << ", entries = " << stats.entries << endl;
+    };
+
+    // Parsed separately, so only structurally equal.
+    set a(ctx, "{ [i,j] : 0 <= i < 10 and i <= j < 10 }");
+    set b(ctx, "{ [i,j] : 0 <= i < 10 and i <= j < 10 }");
+
+    cout << "empty: " << a.is_empty() << " " << b.is_empty() << endl;
+    cout << "lexmin: "; p.print(a.lex_minimum()); cout << " ";
+    p.print(b.lex_minimum()); cout << endl;
+
+    auto loc_space = local_space(a.get_space());
+    auto j = expression::variable(loc_space, space::variable, 1);
+    cout << "max j: " << a.maximum(j).integer() << " "
+         << b.maximum(j).integer() << endl;
+    print_stats();
+
+    union_map u(ctx, "{ A[i] -> B[i] : 0 <= i < 10; B[i] -> C[i+1] : 0 <= i < 5 }");
+    union_map v(ctx, "{ B[i] -> C[i+1] : 0 <= i < 5; A[i] -> B[i] : 0 <= i < 10 }");
+    cout << "subset: " << u.is_subset_of(v) << " " << v.is_subset_of(u) << " "
+         << v.is_subset_of(v) << endl;
+    print_stats();
+
+    // Coalescing works on the set itself, and then finds the
+    // coalesced form as the result of itself.
+    set c(ctx, "{ [i] : 0 <= i < 5 or 5 <= i < 10 }");
+    c.coalesce();
+    set d = c;
+    d.coalesce();
+    cout << "coalesced: "; p.print(d); cout << endl;
+    print_stats();
+
+    ctx.enable_result_cache(0);
+    cout << "empty: " << a.is_empty() << endl;
+    print_stats();
+    cout << "evictions: " << ctx.cache()->stats().evictions << endl;
+}
+
+void test_intern(context & ctx, printer &p)
+{
+    cout << "-- Testing interning --" << endl;
+
+    set a(ctx, "{ [i,j] : 0 <= i < 10 and 0 <= j < 10 }");
+    set b(ctx, "{ [i,j] : 0 <= j < 10 and 0 <= i < 10 }");
+    set c(ctx, "{ [i,j] : 0 <= i < 10 and 0 <= j < 5 }");
+
+    set ia = intern(a);
+    set ib = intern(b);
+    set ic = intern(c);
+    cout << "same object: " << (ia.get() == ib.get()) << " "
+         << (ia.get() == ic.get()) << endl;
+    cout << "equal: " << (ia == ib) << " " << (ia == ic) << endl;
+
+    map m(ctx, "{ A[i] -> B[i+1] : 0 <= i < 10 }");
+    map n(ctx, "{ A[i] -> B[j] : j = i + 1 and 0 <= i < 10 }");
+    cout << "same map: " << (intern(m).get() == intern(n).get()) << endl;
+
+    cout << "interned: " << ctx.interned_objects().size() << endl;
+    ctx.interned_objects().clear();
+}
+
+void test_hashing(context & ctx, printer &p)
+{
+    cout << "-- Testing hashing and ordering --" << endl;
+
+    vector<set> sets = {
+        set(ctx, "{ [i] : 0 <= i < 10 }"),
+        set(ctx, "{ [i] : 0 <= i < 20 }"),
+        set(ctx, "{ [i] : i >= 0 and i < 10 }"),
+        set(ctx, "{ [i] : 0 <= i < 10 }")
+    };
+
+    std::unordered_map<set, int, std::hash<set>, plain_equal<set>> counts;
+    for (const auto & s : sets)
+        ++counts[s];
+    cout << "distinct sets: " << counts.size()
+         << ", count of first: " << counts[sets[0]] << endl;
+
+    std::sort(sets.begin(), sets.end());
+    sets.erase(std::unique(sets.begin(), sets.end(), plain_equal<set>()), sets.end());
+    cout << "after sort and unique: " << sets.size() << endl;
+
+    set a(ctx, "{ [i] : 0 <= i < 10 }");
+    set b(ctx, "{ [i] : 0 <= i < 5 or 5 <= i < 10 }");
+    cout << "differently written: equal " << (a == b)
+         << ", plainly equal " << plain_equal<set>()(a, b) << endl;
+
+    std::unordered_map<map, int, std::hash<map>, plain_equal<map>> maps;
+    ++maps[map(ctx, "{ A[i] -> B[i] }")];
+    ++maps[map(ctx, "{ A[j] -> B[j] }")];
+    ++maps[map(ctx, "{ A[i] -> B[i+1] }")];
+    cout << "distinct maps: " << maps.size() << endl;
+
+    std::unordered_map<space, int> spaces;
+    ++spaces[space(ctx, set_tuple("A", 2))];
+    ++spaces[space(ctx, set_tuple("A", 2))];
+    ++spaces[space(ctx, set_tuple("B", 2))];
+    cout << "distinct spaces: " << spaces.size() << endl;
+    cout << "A < B: " << (space(ctx, set_tuple("A", 2)) < space(ctx, set_tuple("B", 2)))
+         << endl;
+
+    vector<space> sorted_spaces = {
+        space(ctx, set_tuple("B", 1)),
+        space(ctx, set_tuple("A", 2)),
+        space(ctx, set_tuple("A", 1)),
+        space(ctx, input_tuple("A", 1), output_tuple("B", 1)),
+        space(ctx, set_tuple("A", 1))
+    };
+    std::sort(sorted_spaces.begin(), sorted_spaces.end());
+    sorted_spaces.erase(std::unique(sorted_spaces.begin(), sorted_spaces.end()),
+                        sorted_spaces.end());
+    cout << "sorted spaces:";
+    for (const auto & s : sorted_spaces)
+    {
+        char * text = isl_space_to_str(s.get());
+        cout << " " << text;
+        free(text);
+    }
+    cout << endl;
+
+    std::unordered_map<identifier, int> ids;
+    ++ids[identifier("x")];
+    ++ids[identifier("x")];
+    ++ids[identifier("y")];
+    cout << "distinct identifiers: " << ids.size() << endl;
+}
+
+void test_identifiers(context & ctx, printer &p)
+{
+    cout << "-- Testing identifier cache --" << endl;
+
+    int data;
+    isl_id * a = identifier("x", &data).c_id(ctx);
+    isl_id * b = identifier("x", &data).c_id(ctx);
+    isl_id * c = identifier("x").c_id(ctx);
+    cout << "same id: " << (a == b) << " " << (a == c) << endl;
+    isl_id_free(a);
+    isl_id_free(b);
+    isl_id_free(c);
+
+    using isl::tuple;
+
+    space s1(ctx, tuple({"N"}), tuple({"i", "j"}));
+    space s2(ctx, tuple({"N"}), tuple({"i", "j"}));
+    cout << "equal spaces: " << (s1 == s2) << endl;
+}
+
+void test_space_cache(context & ctx, printer &p)
+{
+    using isl::tuple;
+
+    cout << "-- Testing space cache --" << endl;
+
+    space a = shared_space(ctx, tuple({"N"}), tuple("S", 2), tuple("T", 1));
+    space b = shared_space(ctx, tuple({"N"}), tuple("S", 2), tuple("T", 1));
+    space c = shared_space(ctx, tuple({"N"}), tuple("S", 3), tuple("T", 1));
+    space d = shared_space(ctx, set_tuple("S", 2));
+    cout << "shared: " << (a.get() == b.get()) << " " << (a.get() == c.get()) << endl;
+    cout << "equal to built: "
+         << (a == space(ctx, tuple({"N"}), tuple("S", 2), tuple("T", 1))) << endl;
+    cout << "cached layouts: " << ctx.spaces().size() << endl;
+
+    space_registry<string> registry;
+    registry.insert("S", d);
+    int built = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        registry.get("T", [&]{ ++built; return space(ctx, set_tuple("T", 1)); });
+    }
+    cout << "registered: " << registry.size() << ", built: " << built
+         << ", found S: " << (registry.find("S") != nullptr)
+         << ", found U: " << (registry.find("U") != nullptr) << endl;
+    cout << "S dimensions: " << registry.at("S").dimension(space::variable) << endl;
+}
+
+template <typename T, typename = void>
+struct can_add_dimensions : std::false_type {};
+
+template <typename T>
+struct can_add_dimensions<T, decltype(std::declval<T&>().add_dimensions(space::variable), void())>
+        : std::true_type {};
+
+void test_typed(context & ctx, printer &p)
+{
+    cout << "-- Testing typed spaces --" << endl;
+
+    typedef static_space<0, 2, 1> S_to_T;
+    static_assert(S_to_T::dimension(space::input) == 2, "");
+    static_assert(typed_set<0, 2>::dimensions() == 2, "");
+    static_assert(can_add_dimensions<set>::value, "");
+    static_assert(!can_add_dimensions<typed_set<0, 2>>::value, "");
+
+    S_to_T spc(ctx, "S", "T");
+    auto sum = spc.in<0>() + spc.in<1>();
+    cout << "expression: "; p.print(sum); cout << endl;
+
+    typed_map<0, 2, 1> m(ctx, "{ S[i,j] -> T[i+j] : 0 <= i,j < 4 }");
+    typed_set<0, 1> r = m.range();
+    cout << "range: "; p.print<set>(r); cout << " with " << r.dimensions() << " dimension" << endl;
+
+    typed_set<0, 2> d(ctx, "{ S[i,j] : i = j and 0 <= i < 4 }");
+    cout << "image: "; p.print<set>(m(d)); cout << endl;
+
+    try
+    {
+        typed_set<0, 3> wrong(ctx, "{ S[i,j] }");
+        cout << "no error" << endl;
+    }
+    catch (isl::error & e)
+    {
+        cout << "error: " << e.what() << endl;
+    }
+}
+
+void test_matrix_bulk(context & ctx, printer &p)
+{
+    cout << "-- Testing bulk matrix access --" << endl;
+
+    int64_t data[] = { 1, -2, 3, 1ll << 40, -(1ll << 40), INT64_MIN };
+    matrix m = matrix::from_int64(ctx, 2, 3, data);
+    print(m, 21);
+
+    vector<int64_t> out;
+    bool fits = m.to_int64(out);
+    cout << "fits: " << fits << ", equal: "
+         << std::equal(out.begin(), out.end(), data) << endl;
+
+    // 2^64 + 5 and -7
+    matrix::integer_buffer big;
+    big.limbs = { 5, 1, 7 };
+    big.sizes = { 2, -1 };
+    matrix b = matrix::from_integers(ctx, 1, 2, big);
+    cout << "big fits: " << b.to_int64(out) << ", second: " << out[1] << endl;
+
+    matrix::integer_buffer round_trip;
+    b.to_integers(round_trip);
+    cout << "round trip equal: " << (round_trip.limbs == big.limbs &&
+                                     round_trip.sizes == big.sizes) << endl;
+}
+
+void test_matrix_blocks(context & ctx, printer &p)
+{
+    cout << "-- Testing matrix block operations --" << endl;
+
+    int64_t data[] = { 1, 2, 3,
+                       4, 5, 6,
+                       7, 8, 9 };
+    matrix m = matrix::from_int64(ctx, 3, 3, data);
+
+    cout << "Submatrix:" << endl;
+    print(m.submatrix(1, 1, 2, 2));
+
+    matrix d = m;
+    d.drop_columns(0, 1);
+    d.insert_zero_columns(2, 1);
+    d.swap_rows(0, 2);
+    cout << "Dropped, inserted, swapped:" << endl;
+    print(d);
+
+    cout << "Horizontal:" << endl;
+    print(matrix::concat_horizontal(m, d));
+    cout << "Vertical:" << endl;
+    print(matrix::concat_vertical(m.submatrix(0, 0, 1, 3), d.submatrix(0, 0, 1, 3)));
+}
+
+void test_matrix_algebra(context & ctx, printer &p)
+{
+    cout << "-- Testing matrix algebra --" << endl;
+
+    // A unimodular transformation with a given first row.
+    int64_t row[] = { 2, 3, 5 };
+    matrix t = matrix::from_int64(ctx, 1, 3, row).unimodular_complete();
+    cout << "Completed:" << endl;
+    print(t);
+    cout << "Rank: " << t.rank() << endl;
+
+    matrix t_inv = t.left_inverse();
+    cout << "Inverse:" << endl;
+    print(t_inv);
+    cout << "Product:" << endl;
+    print(t * t_inv);
+
+    int64_t data[] = { 4, 6, 2,
+                       2, 4, 6 };
+    matrix m = matrix::from_int64(ctx, 2, 3, data);
+    matrix::hermite_form hnf = m.left_hermite();
+    cout << "Left Hermite:" << endl;
+    print(hnf.h);
+    cout << "Same as M * U: "
+         << (isl_mat_is_equal(hnf.h.get(), (m * hnf.u).get()) == isl_bool_true ? "yes" : "no")
+         << endl;
+    hnf = m.right_hermite();
+    cout << "Right Hermite:" << endl;
+    print(hnf.h);
+    cout << "Same as U * M: "
+         << (isl_mat_is_equal(hnf.h.get(), (hnf.u * m).get()) == isl_bool_true ? "yes" : "no")
+         << endl;
+
+    cout << "Transposed:" << endl;
+    print(m.transpose());
+
+    try {
+        m.right_inverse();
+        cout << "Unexpected right inverse." << endl;
+    } catch (error & e) {
+        cout << "No right inverse: " << e.what() << endl;
+    }
+
+    int64_t v[] = { 1, 1, 1 };
+    vector<int64_t> tv;
+    (t * column_vector::from_int64(ctx, 3, v)).to_int64(tv);
+    cout << "T * (1,1,1) =";
+    for (auto x : tv)
+        cout << " " << x;
+    cout << endl;
+}
+
+void test_integer(context & ctx, printer &p)
+{
+    cout << "-- Testing integers --" << endl;
+
+    integer a(ctx, 84);
+    integer b(ctx, -36);
+    cout << "a + b = " << (a + b).to_string() << endl;
+    cout << "a * b = " << (a * b).to_string() << endl;
+    cout << "a / b = " << (a / b).to_string() << endl;
+    cout << "floor(a / b) = " << floor_div(a, b).to_string() << endl;
+    cout << "ceil(a / b) = " << ceil_div(a, b).to_string() << endl;
+    cout << "a mod b = " << mod(a, b).to_string() << endl;
+    cout << "gcd = " << gcd(a, b).to_string() << endl;
+    cout << "lcm = " << lcm(a, b).to_string() << endl;
+    cout << "a < b: " << (a < b) << endl;
+
+    // Overflows into an isl value and comes back.
+    integer big(ctx, INT64_MAX);
+    big *= 4;
+    cout << "Big: " << big.to_string()
+         << " fits: " << big.fits_int64() << endl;
+    big = big / 8 + 1;
+    cout << "Small again: " << big.to_string()
+         << " fits: " << big.fits_int64() << endl;
+
+    integer from_value(value(ctx, 7));
+    cout << "From value: ";
+    p.print(from_value);
+    cout << endl;
+
+    try {
+        a / integer(ctx, 0);
+        cout << "Unexpected division." << endl;
+    } catch (error & e) {
+        cout << e.what() << endl;
+    }
+}
+
+void test_point_coordinates(context & ctx, printer &p)
+{
+    cout << "-- Testing point coordinates --" << endl;
+
+    set s(ctx, "[n] -> { [i, j, k] : n = 5 and i = n - 1 and j = -3 and k = 2 * n }");
+    point pt = s.single_point();
+    p.print(pt);
+    cout << endl;
+
+    vector<int64_t> vars;
+    bool fit = pt.coordinates(vars);
+    cout << "Variables:";
+    for (auto x : vars)
+        cout << " " << x;
+    cout << " fit: " << fit << endl;
+
+    int64_t params[1];
+    pt.coordinates(space::parameter, params);
+    cout << "Parameter: " << params[0] << endl;
+
+    set huge(ctx, "{ [i] : i = 100000000000000000000 }");
+    fit = huge.single_point().coordinates(vars);
+    cout << "Huge: " << vars[0] << " fit: " << fit << endl;
+}
+
+void test_printer_targets(context & ctx, printer &p)
+{
+    cout << "-- Testing printer targets --" << endl;
+
+    union_map maps(ctx, "{ A[i] -> B[i + 1]; B[i] -> C[2i]; C[i] -> A[i - 1] }");
+
+    printer to_string(ctx, printer::to_string);
+    to_string.print_all(maps);
+    cout << "String:" << endl << to_string.str();
+
+    // A tiny buffer, so the stream is written several times.
+    ostringstream stream;
+    {
+        printer to_stream(ctx, stream, 16);
+        to_stream.print_all(maps);
+        to_stream.print(set(ctx, "{ [i] : 0 <= i < 10 }"));
+        to_stream.end_line();
+    }
+    cout << "Stream:" << endl << stream.str();
+
+    vector<set> sets = { set(ctx, "{ [0] }"), set(ctx, "{ [1] }") };
+    printer to_file(ctx, stdout);
+    cout << "File:" << endl;
+    to_file.print_all(sets);
+}
+
+void test_small_matrix(context & ctx, printer &p)
+{
+    cout << "-- Testing small matrix --" << endl;
+
+    small_matrix m(2, 4);
+    m(0,0) = 1; m(0,1) = 2; m(0,2) = 3; m(0,3) = 4;
+    m(1,0) = 2; m(1,1) = 4; m(1,2) = 7; m(1,3) = 8;
+
+    small_matrix k;
+    unsigned rank = 0;
+    bool ok = m.right_kernel(k) && m.rank(rank);
+    matrix isl_kernel = m.to_matrix(ctx).right_kernel();
+    cout << "Rank: " << rank << endl;
+    cout << "Kernel:" << endl;
+    print(k.to_matrix(ctx));
+    cout << "Same as isl: "
+         << (ok && isl_mat_is_equal(k.to_matrix(ctx).get(), isl_kernel.get()) == isl_bool_true ? "yes" : "no") << endl;
+
+    small_matrix big(1, 1);
+    big(0,0) = INT64_MAX;
+    small_matrix two(1, 1);
+    two(0,0) = 2;
+    small_matrix unused;
+    cout << "Overflow detected: "
+         << (small_matrix::product(big, two, unused) ? "no" : "yes") << endl;
+    cout << "Product with fallback: ";
+    p.print(product(big, two, ctx)(0,0).value());
+    cout << endl;
+
+    small_matrix wide(2, 2);
+    wide(0,0) = INT64_MAX; wide(0,1) = INT64_MAX - 1;
+    wide(1,0) = INT64_MAX - 1; wide(1,1) = INT64_MAX;
+    unsigned unused_rank;
+    cout << "Rank overflow detected: " << (wide.rank(unused_rank) ? "no" : "yes") << endl;
+    cout << "Rank with fallback: " << isl::rank(wide, ctx) << endl;
+    small_matrix unused_h;
+    cout << "Hermite overflow detected: " << (wide.left_hermite(unused_h) ? "no" : "yes") << endl;
+    matrix u = wide.to_matrix(ctx);
+    matrix h = left_hermite(wide, ctx, &u);
+    matrix::hermite_form isl_form = wide.to_matrix(ctx).left_hermite();
+    cout << "Hermite with fallback same as isl: "
+         << (isl_mat_is_equal(h.get(), isl_form.h.get()) == isl_bool_true &&
+             isl_mat_is_equal(u.get(), isl_form.u.get()) == isl_bool_true ? "yes" : "no") << endl;
+}
+
+void test_serialization(context & ctx, printer &p)
+{
+    cout << "-- Testing serialization --" << endl;
+
+    auto yes_no = [](bool b) { return b ? "yes" : "no"; };
+
+    set s(ctx, "[n] -> { S[i, j] : 0 <= i < n and 0 <= j <= i and i mod 3 = 1 "
+               "and exists (k : j = 2k + floor(i / 5)) }");
+    vector<char> buffer;
+    serialize(s, buffer);
+    set s2 = deserialize<set>(ctx, buffer);
+    cout << "Set: " << yes_no(s == s2) << endl;
+    cout << "Bytes: " << buffer.size() << endl;
+
+    basic_set bs(ctx, "{ [x] : x = 7 * floor(x / 7) and x >= 1000000000000000000000 }");
+    buffer.clear();
+    serialize(bs, buffer);
+    basic_set bs2 = deserialize<basic_set>(ctx, buffer);
+    cout << "Basic set with large numbers: " << yes_no(bs == bs2) << endl;
+
+    map m(ctx, "[n] -> { A[i] -> [B[j] -> C[k]] : 0 <= i < n and j = i + 1 and k = 2i }");
+    buffer.clear();
+    serialize(m, buffer);
+    map m2 = deserialize<map>(ctx, buffer);
+    cout << "Nested map: " << yes_no(m == m2) << endl;
+    p.print(m2);
+    p.end_line();
+
+    basic_map bm(ctx, "{ [i] -> [o] : o = floor(i / 4) }");
+    buffer.clear();
+    serialize(bm, buffer);
+    basic_map bm2 = deserialize<basic_map>(ctx, buffer);
+    cout << "Basic map: " << yes_no(isl_basic_map_is_equal(bm.get(), bm2.get()) == isl_bool_true) << endl;
+
+    union_set us(ctx, "[n] -> { A[i] : 0 <= i < n; B[]; C[i, j] : i = j or i = -j }");
+    buffer.clear();
+    serialize(us, buffer);
+    union_set us2 = deserialize<union_set>(ctx, buffer);
+    cout << "Union set: " << yes_no(isl_union_set_is_equal(us.get(), us2.get()) == isl_bool_true) << endl;
+
+    union_map um(ctx, "[m] -> { A[i] -> B[i + 1]; B[i] -> C[2i] : i < m; C[i] -> [] }");
+    size_t start = buffer.size();
+    serialize(um, buffer);
+    union_map um2 = deserialize<union_map>(ctx, byte_span(buffer.data() + start, buffer.size() - start));
+    cout << "Union map after other data: " << yes_no(isl_union_map_is_equal(um.get(), um2.get()) == isl_bool_true) << endl;
+
+    try {
+        deserialize<union_set>(ctx, byte_span(buffer.data() + start, buffer.size() - start));
+        cout << "Wrong kind: accepted" << endl;
+    }
+    catch (error & e) {
+        cout << "Wrong kind: " << e.what() << endl;
+    }
+
+    try {
+        deserialize<union_map>(ctx, byte_span(buffer.data() + start, buffer.size() - start - 8));
+        cout << "Truncated: accepted" << endl;
+    }
+    catch (error & e) {
+        cout << "Truncated: " << e.what() << endl;
+    }
+}
+
+void test_union_reader(context & ctx, printer &p)
+{
+    cout << "-- Testing union reader --" << endl;
+
+    {
+        union_set u(ctx);
+        union_reader reader(ctx, "{X[a,b]}; {Y[a,b]}");
+        reader.read_into(u);
+        cout << "Sets: "; p.print(u); p.end_line();
+    }
+
+    const char * path = "test-union-reader.txt";
+    {
+        union_map maps(ctx, "[n] -> { A[i] -> B[i + 1] : 0 <= i < n; "
+                            "B[i] -> C[2i, floor(i / 2)]; C[i, j] -> [A[i] -> A[j]] }");
+        FILE * file = fopen(path, "w");
+        printer to_file(ctx, file);
+        to_file.print(maps);
+        to_file.end_line();
+        to_file.print(union_map(ctx, "{ A[i] -> B[i - 1] : i > 10 }"));
+        to_file.end_line();
+        to_file.flush();
+        fclose(file);
+    }
+
+    {
+        mapped_file file(path);
+        union_reader reader(ctx, file);
+        reader.for_each_map([&](const map & m){
+            cout << "-- "; p.print(m); p.end_line();
+            return true;
+        });
+        cout << "Read " << reader.position() << " of " << file.size() << " bytes" << endl;
+    }
+
+    {
+        mapped_file file(path);
+        union_map maps(ctx);
+        union_reader(ctx, file).read_into(maps);
+        cout << "Union: "; p.print(maps); p.end_line();
+    }
+
+    remove(path);
+
+    try {
+        union_map maps(ctx);
+        union_reader(ctx, "{ A[i] -> B[i]; B[i] -> C[i]").read_into(maps);
+        cout << "Unterminated: accepted" << endl;
+    }
+    catch (error & e) {
+        cout << "Unterminated: " << e.what() << endl;
+    }
+}
+
+void test_parse_cache(context & ctx, printer &p)
+{
+    cout << "-- Testing parse cache --" << endl;
+
+    set a = parse<set>(ctx, "{ [i] : 0 <= i < 10 }");
+    set b = parse<set>(ctx, string("{ [i] : 0 <= i < 10 }"));
+    cout << "same set: " << (a.get() == b.get()) << endl;
+
+    // The same text as a map is a different object.
+    map m = parse<map>(ctx, "{ [i] -> [i + 1] }");
+    map n = parse<map>(ctx, "{ [i] -> [i + 1] }");
+    cout << "same map: " << (m.get() == n.get()) << endl;
+
+    vector<const char*> texts = {
+        "{ A[i] -> B[i] }", "{ B[i] -> C[i] }", "{ A[i] -> B[i] }", "{ B[i] -> C[i] }"
+    };
+    vector<union_map> maps;
+    parse_all(ctx, texts, maps);
+    for (const auto & u : maps)
+    {
+        p.print(u);
+        p.end_line();
+    }
+    cout << "shared: " << (maps[0].get() == maps[2].get()) << endl;
+
+    const parse_cache::statistics & stats = ctx.parsed_texts().stats();
+    cout << "hits: " << stats.hits << ", misses: " << stats.misses
+         << ", entries: " << stats.entries
+         << ", hit rate: " << stats.hit_rate() << endl;
+
+    ctx.parsed_texts().clear();
+    cout << "after clear: " << ctx.parsed_texts().size() << endl;
+}
+
+void test_point_enumeration(context & ctx, printer &p)
+{
+    cout << "-- Testing point enumeration --" << endl;
+
+    set s(ctx, "{ [i, j] : 0 <= i < 3 and 0 <= j <= i }");
+    s.for_each_point([&](const point & pt){
+        p.print(pt);
+        p.end_line();
+        return true;
+    });
+
+    basic_set b(ctx, "{ [i] : 0 <= i < 10 and i mod 3 = 0 }");
+    int count = 0;
+    b.for_each_point([&](const point &){ return ++count < 2; });
+    cout << "Stopped after: " << count << endl;
+
+    set big(ctx, "{ [i, j] : 0 <= i < 100 and 0 <= j < 100 and i + j < 150 }");
+    size_t batches = 0, points = 0;
+    int64_t sum = 0;
+    big.for_each_point_batch([&](const point_batch & batch){
+        ++batches;
+        points += batch.size();
+        const int64_t * i = batch.variable(0);
+        const int64_t * j = batch.variable(1);
+        for (size_t k = 0; k < batch.size(); ++k)
+            sum += i[k] + j[k];
+        return true;
+    }, 1000);
+    cout << "Batches: " << batches << ", points: " << points << ", sum: " << sum << endl;
+
+    try {
+        set(ctx, "{ [i] : i >= 0 }").for_each_point([](const point &){ return true; });
+        cout << "Unbounded: accepted" << endl;
+    }
+    catch (error & e) {
+        cout << "Unbounded: " << e.what() << endl;
+    }
+
+    try {
+        big.for_each_point_batch([](const point_batch &){ return true; }, 0);
+        cout << "Zero batch size: accepted" << endl;
+    }
+    catch (error & e) {
+        cout << "Zero batch size: " << e.what() << endl;
+    }
+
+    point_batch one(1, 1);
+    int64_t x = 7;
+    one.push_back(&x);
+    try {
+        one.push_back(&x);
+        cout << "Full batch: accepted" << endl;
+    }
+    catch (error & e) {
+        cout << "Full batch: " << e.what() << endl;
+    }
+}
+
+void test_point_cursor(context & ctx, printer &p)
+{
+    cout << "-- Testing point cursor --" << endl;
+
+    set s(ctx, "{ [i, j] : 0 <= i < 4 and 0 <= j <= i and (i + j) mod 2 = 0 }");
+
+    auto print_point = [](const vector<int64_t> & pt) {
+        cout << "(";
+        for (size_t i = 0; i < pt.size(); ++i)
+            cout << (i ? ", " : "") << pt[i];
+        cout << ")";
+    };
+
+    vector<int64_t> pt;
+    vector<int64_t> token;
+    {
+        point_cursor cursor(s);
+        cout << "First points:";
+        for (int k = 0; k < 3 && cursor.next(pt); ++k)
+        {
+            cout << " ";
+            print_point(pt);
+        }
+        cout << endl;
+        token = cursor.last();
+    }
+
+    {
+        // Resumes in another context, as another thread would.
+        context other;
+        point_cursor cursor(transfer(s, other), token);
+        point_batch page(2, 2);
+        while (cursor.next_page(page))
+        {
+            cout << "Page:";
+            for (size_t k = 0; k < page.size(); ++k)
+                cout << " (" << page.at(k, 0) << ", " << page.at(k, 1) << ")";
+            cout << endl;
+        }
+    }
+
+    // Bounded below only.
+    point_cursor unbounded(set(ctx, "{ [i] : i >= 10 and i mod 5 = 0 }"));
+    cout << "Unbounded:";
+    for (int k = 0; k < 4 && unbounded.next(pt); ++k)
+        cout << " " << pt[0];
+    cout << endl;
+
+    try {
+        point_batch no_room(1, 0);
+        unbounded.next_page(no_room);
+        cout << "Empty page: accepted" << endl;
+    }
+    catch (error & e) {
+        cout << "Empty page: " << e.what() << endl;
+    }
+}
+
+void test_point_count(context & ctx, printer &p)
+{
+    cout << "-- Testing point count --" << endl;
+
+    set s(ctx, "{ [i, j] : 0 <= i < 100 and 0 <= j <= i and (i + j) mod 3 = 0 }");
+    cout << "Count: "; p.print(s.count()); p.end_line();
+    cout << "Up to 100: " << s.count_upto(100) << endl;
+    cout << "Up to 10000: " << s.count_upto(10000) << endl;
+
+    basic_set b(ctx, "{ [i] : 0 <= i < 7 }");
+    cout << "Basic set: "; p.print(b.count()); p.end_line();
+
+    union_set u(ctx, "{ A[i] : 0 <= i < 10; B[i, j] : 0 <= i, j < 10 }");
+    cout << "Union: "; p.print(u.count()); p.end_line();
+    cout << "Union up to 50: " << u.count_upto(50) << endl;
+
+    set huge(ctx, "{ [i, j, k] : 0 <= i, j, k < 1000000 }");
+    cout << "More than a million: " << (huge.count_upto(1000001) > 1000000) << endl;
+
+    set gaps(ctx, "{ [i, j, k] : 0 <= i < 20 and 0 <= j, k < 3 and i mod 4 = 0 }");
+    cout << "With empty slices: " << gaps.count_upto(1000) << endl;
+    cout << "Empty: " << set(ctx, "{ [i, j] : 0 <= i < 0 }").count_upto(10) << endl;
+
+    try {
+        set(ctx, "{ [i] : i >= 0 }").count();
+        cout << "Unbounded: counted" << endl;
+    }
+    catch (error & e) {
+        cout << "Unbounded: " << e.what() << endl;
+    }
+}
+
 void test_buffer_size(context & ctx, printer &p)
 {
     using isl::tuple;
@@ -363,6 +1323,52 @@ int main()
     test_matrix(ctx, p);
     cout << endl;
     test_dataflow_counts(ctx, p);
+    cout << endl;
+    test_threads();
+    cout << endl;
+    test_transfer(ctx, p);
+    cout << endl;
+    test_parallel(ctx, p);
+    cout << endl;
+    test_budget(ctx, p);
+    cout << endl;
+    test_result_cache();
+    cout << endl;
+    test_intern(ctx, p);
+    cout << endl;
+    test_hashing(ctx, p);
+    cout << endl;
+    test_identifiers(ctx, p);
+    cout << endl;
+    test_space_cache(ctx, p);
+    cout << endl;
+    test_typed(ctx, p);
+    cout << endl;
+    test_matrix_bulk(ctx, p);
+    cout << endl;
+    test_matrix_blocks(ctx, p);
+    cout << endl;
+    test_small_matrix(ctx, p);
+    cout << endl;
+    test_matrix_algebra(ctx, p);
+    cout << endl;
+    test_integer(ctx, p);
+    cout << endl;
+    test_point_coordinates(ctx, p);
+    cout << endl;
+    test_printer_targets(ctx, p);
+    cout << endl;
+    test_serialization(ctx, p);
+    cout << endl;
+    test_union_reader(ctx, p);
+    cout << endl;
+    test_parse_cache(ctx, p);
+    cout << endl;
+    test_point_enumeration(ctx, p);
+    cout << endl;
+    test_point_cursor(ctx, p);
+    cout << endl;
+    test_point_count(ctx, p);
     //cout << endl;
     //test_buffer_size(ctx, p);
 
@@ -0,0 +1,421 @@
+/*
+isl-cpp: C++ bindings to the ISL (Integer Set Library)
+
+Copyright (C) 2014  Jakob Leben <jakob.leben@gmail.com>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "transfer.hpp"
+
+#include <climits>
+#include <cstdlib>
+#include <vector>
+
+namespace isl {
+
+namespace {
+
+isl_val * transfer_integer( isl_val * v, isl_ctx * target )
+{
+    const size_t chunk_size = sizeof(unsigned long);
+
+    int n_chunks = isl_val_n_abs_num_chunks(v, chunk_size);
+    bool negative = isl_val_is_neg(v);
+
+    isl_val * result;
+    if (n_chunks <= 1)
+    {
+        unsigned long magnitude = 0;
+        isl_val_get_abs_num_chunks(v, chunk_size, &magnitude);
+        if (magnitude <= (unsigned long) LONG_MAX)
+        {
+            long x = (long) magnitude;
+            return isl_val_int_from_si(target, negative ? -x : x);
+        }
+        result = isl_val_int_from_ui(target, magnitude);
+    }
+    else
+    {
+        std::vector<unsigned long> chunks(n_chunks);
+        isl_val_get_abs_num_chunks(v, chunk_size, chunks.data());
+        result = isl_val_int_from_chunks(target, n_chunks, chunk_size, chunks.data());
+    }
+
+    if (negative)
+        result = isl_val_neg(result);
+    return result;
+}
+
+// Takes v.
+isl_val * transfer_val( isl_val * v, isl_ctx * target )
+{
+    if (!v)
+        return nullptr;
+
+    isl_val * result;
+    if (isl_val_is_int(v))
+    {
+        result = transfer_integer(v, target);
+    }
+    else if (isl_val_is_rat(v))
+    {
+        isl_val * den = isl_val_get_den_val(v);
+        isl_val * num = isl_val_mul(isl_val_copy(v), isl_val_copy(den));
+        result = isl_val_div(transfer_integer(num, target),
+                             transfer_integer(den, target));
+        isl_val_free(num);
+        isl_val_free(den);
+    }
+    else
+    {
+        isl_val_free(v);
+        throw error("Can not transfer non-rational value.");
+    }
+
+    isl_val_free(v);
+    return result;
+}
+
+// Takes m.
+isl_mat * transfer_mat( isl_mat * m, isl_ctx * target )
+{
+    if (!m)
+        return nullptr;
+
+    int rows = isl_mat_rows(m);
+    int cols = isl_mat_cols(m);
+
+    isl_mat * result = isl_mat_alloc(target, rows, cols);
+    for (int r = 0; r < rows; ++r)
+    {
+        for (int c = 0; c < cols; ++c)
+        {
+            isl_val * v = transfer_val(isl_mat_get_element_val(m, r, c), target);
+            result = isl_mat_set_element_val(result, r, c, v);
+        }
+    }
+
+    isl_mat_free(m);
+    return result;
+}
+
+isl_id * transfer_id( isl_id * id, isl_ctx * target )
+{
+    isl_id * result = isl_id_alloc(target, isl_id_get_name(id), isl_id_get_user(id));
+    isl_id_free(id);
+    return result;
+}
+
+// Copies tuple and dimension identifiers of 'type' from 'source' to 'dest'.
+isl_space * transfer_ids( isl_space * dest, isl_space * source,
+                          isl_dim_type type, isl_ctx * target )
+{
+    if (type != isl_dim_param && isl_space_has_tuple_id(source, type) == isl_bool_true)
+    {
+        isl_id * id = transfer_id(isl_space_get_tuple_id(source, type), target);
+        dest = isl_space_set_tuple_id(dest, type, id);
+    }
+
+    int n = isl_space_dim(source, type);
+    for (int i = 0; i < n; ++i)
+    {
+        if (isl_space_has_dim_id(source, type, i) != isl_bool_true)
+            continue;
+        isl_id * id = transfer_id(isl_space_get_dim_id(source, type, i), target);
+        dest = isl_space_set_dim_id(dest, type, i, id);
+    }
+
+    return dest;
+}
+
+// Takes s.
+isl_space * transfer_space( isl_space * s, isl_ctx * target )
+{
+    if (!s)
+        return nullptr;
+
+    isl_space * result;
+
+    if (isl_space_is_map(s))
+    {
+        isl_space * domain = transfer_space(isl_space_domain(isl_space_copy(s)), target);
+        isl_space * range = transfer_space(isl_space_range(isl_space_copy(s)), target);
+        result = isl_space_map_from_domain_and_range(domain, range);
+    }
+    else if (isl_space_is_wrapping(s))
+    {
+        isl_space * inner = transfer_space(isl_space_unwrap(isl_space_copy(s)), target);
+        result = isl_space_wrap(inner);
+    }
+    else if (isl_space_is_params(s))
+    {
+        result = isl_space_params_alloc(target, isl_space_dim(s, isl_dim_param));
+        result = transfer_ids(result, s, isl_dim_param, target);
+    }
+    else
+    {
+        result = isl_space_set_alloc(target,
+                                     isl_space_dim(s, isl_dim_param),
+                                     isl_space_dim(s, isl_dim_set));
+        result = transfer_ids(result, s, isl_dim_param, target);
+        result = transfer_ids(result, s, isl_dim_set, target);
+    }
+
+    isl_space_free(s);
+    return result;
+}
+
+isl_basic_set * transfer_basic_set( isl_basic_set * bs, isl_ctx * target )
+{
+    isl_mat * eq = isl_basic_set_equalities_matrix
+            (bs, isl_dim_param, isl_dim_set, isl_dim_div, isl_dim_cst);
+    isl_mat * ineq = isl_basic_set_inequalities_matrix
+            (bs, isl_dim_param, isl_dim_set, isl_dim_div, isl_dim_cst);
+
+    return isl_basic_set_from_constraint_matrices
+            (transfer_space(isl_basic_set_get_space(bs), target),
+             transfer_mat(eq, target),
+             transfer_mat(ineq, target),
+             isl_dim_param, isl_dim_set, isl_dim_div, isl_dim_cst);
+}
+
+isl_basic_map * transfer_basic_map( isl_basic_map * bm, isl_ctx * target )
+{
+    isl_mat * eq = isl_basic_map_equalities_matrix
+            (bm, isl_dim_param, isl_dim_in, isl_dim_out, isl_dim_div, isl_dim_cst);
+    isl_mat * ineq = isl_basic_map_inequalities_matrix
+            (bm, isl_dim_param, isl_dim_in, isl_dim_out, isl_dim_div, isl_dim_cst);
+
+    return isl_basic_map_from_constraint_matrices
+            (transfer_space(isl_basic_map_get_space(bm), target),
+             transfer_mat(eq, target),
+             transfer_mat(ineq, target),
+             isl_dim_param, isl_dim_in, isl_dim_out, isl_dim_div, isl_dim_cst);
+}
+
+struct set_transfer
+{
+    isl_ctx * target;
+    isl_set * result;
+};
+
+isl_stat transfer_basic_set_into( isl_basic_set * bs, void * data )
+{
+    auto t = static_cast<set_transfer*>(data);
+    isl_basic_set * b = transfer_basic_set(bs, t->target);
+    t->result = isl_set_union(t->result, isl_set_from_basic_set(b));
+    isl_basic_set_free(bs);
+    return t->result ? isl_stat_ok : isl_stat_error;
+}
+
+// Returns null if a part can not be transferred.
+isl_set * transfer_set( isl_set * s, isl_ctx * target )
+{
+    set_transfer t { target,
+                isl_set_empty(transfer_space(isl_set_get_space(s), target)) };
+    if (isl_set_foreach_basic_set(s, &transfer_basic_set_into, &t) == isl_stat_error)
+    {
+        isl_set_free(t.result);
+        return nullptr;
+    }
+    return t.result;
+}
+
+struct map_transfer
+{
+    isl_ctx * target;
+    isl_map * result;
+};
+
+isl_stat transfer_basic_map_into( isl_basic_map * bm, void * data )
+{
+    auto t = static_cast<map_transfer*>(data);
+    isl_basic_map * b = transfer_basic_map(bm, t->target);
+    t->result = isl_map_union(t->result, isl_map_from_basic_map(b));
+    isl_basic_map_free(bm);
+    return t->result ? isl_stat_ok : isl_stat_error;
+}
+
+// Returns null if a part can not be transferred.
+isl_map * transfer_map( isl_map * m, isl_ctx * target )
+{
+    map_transfer t { target,
+                isl_map_empty(transfer_space(isl_map_get_space(m), target)) };
+    if (isl_map_foreach_basic_map(m, &transfer_basic_map_into, &t) == isl_stat_error)
+    {
+        isl_map_free(t.result);
+        return nullptr;
+    }
+    return t.result;
+}
+
+struct union_set_transfer
+{
+    isl_ctx * target;
+    isl_union_set * result;
+};
+
+isl_stat transfer_set_into( isl_set * s, void * data )
+{
+    auto t = static_cast<union_set_transfer*>(data);
+    t->result = isl_union_set_add_set(t->result, transfer_set(s, t->target));
+    isl_set_free(s);
+    return t->result ? isl_stat_ok : isl_stat_error;
+}
+
+struct union_map_transfer
+{
+    isl_ctx * target;
+    isl_union_map * result;
+};
+
+isl_stat transfer_map_into( isl_map * m, void * data )
+{
+    auto t = static_cast<union_map_transfer*>(data);
+    t->result = isl_union_map_add_map(t->result, transfer_map(m, t->target));
+    isl_map_free(m);
+    return t->result ? isl_stat_ok : isl_stat_error;
+}
+
+isl_aff * transfer_aff( isl_aff * a, isl_ctx * target )
+{
+    // Work with integer coefficients scaled by the common denominator.
+    isl_val * den = isl_aff_get_denominator_val(a);
+
+    isl_space * domain = transfer_space(isl_aff_get_domain_space(a), target);
+    isl_aff * result = isl_aff_zero_on_domain(isl_local_space_from_space(domain));
+
+    isl_val * cst = isl_val_mul(isl_aff_get_constant_val(a), isl_val_copy(den));
+    result = isl_aff_set_constant_val(result, transfer_val(cst, target));
+
+    isl_dim_type types[] = { isl_dim_param, isl_dim_in };
+    for (isl_dim_type type : types)
+    {
+        int n = isl_aff_dim(a, type);
+        for (int i = 0; i < n; ++i)
+        {
+            isl_val * c = isl_aff_get_coefficient_val(a, type, i);
+            c = isl_val_mul(c, isl_val_copy(den));
+            result = isl_aff_set_coefficient_val(result, type, i, transfer_val(c, target));
+        }
+    }
+
+    int n_div = isl_aff_dim(a, isl_dim_div);
+    for (int i = 0; i < n_div; ++i)
+    {
+        isl_val * c = isl_aff_get_coefficient_val(a, isl_dim_div, i);
+        c = isl_val_mul(c, isl_val_copy(den));
+        if (isl_val_is_zero(c))
+        {
+            isl_val_free(c);
+            continue;
+        }
+
+        isl_aff * div = isl_aff_get_div(a, i);
+        isl_aff * term = isl_aff_floor(transfer_aff(div, target));
+        isl_aff_free(div);
+
+        term = isl_aff_scale_val(term, transfer_val(c, target));
+        result = isl_aff_add(result, term);
+    }
+
+    result = isl_aff_scale_down_val(result, transfer_val(den, target));
+    return result;
+}
+
+template <typename T>
+T * transferred( T * result )
+{
+    if (!result)
+    {
+        context::budget_scope::check();
+        throw error("Can not transfer object.");
+    }
+    return result;
+}
+
+}
+
+value transfer( const value & v, const context & target )
+{
+    return transfer_val(v.copy(), target.get());
+}
+
+space transfer( const space & s, const context & target )
+{
+    return transfer_space(s.copy(), target.get());
+}
+
+basic_set transfer( const basic_set & bs, const context & target )
+{
+    return transfer_basic_set(bs.get(), target.get());
+}
+
+set transfer( const set & s, const context & target )
+{
+    return transferred(transfer_set(s.get(), target.get()));
+}
+
+union_set transfer( const union_set & us, const context & target )
+{
+    isl_space * params = transfer_space(isl_union_set_get_space(us.get()), target.get());
+    union_set_transfer t { target.get(), isl_union_set_empty(params) };
+    if (isl_union_set_foreach_set(us.get(), &transfer_set_into, &t) == isl_stat_error)
+    {
+        isl_union_set_free(t.result);
+        t.result = nullptr;
+    }
+    return transferred(t.result);
+}
+
+basic_map transfer( const basic_map & bm, const context & target )
+{
+    return transfer_basic_map(bm.get(), target.get());
+}
+
+map transfer( const map & m, const context & target )
+{
+    return transferred(transfer_map(m.get(), target.get()));
+}
+
+union_map transfer( const union_map & um, const context & target )
+{
+    isl_space * params = transfer_space(isl_union_map_get_space(um.get()), target.get());
+    union_map_transfer t { target.get(), isl_union_map_empty(params) };
+    if (isl_union_map_foreach_map(um.get(), &transfer_map_into, &t) == isl_stat_error)
+    {
+        isl_union_map_free(t.result);
+        t.result = nullptr;
+    }
+    return transferred(t.result);
+}
+
+expression transfer( const expression & e, const context & target )
+{
+    return transfer_aff(e.get(), target.get());
+}
+
+schedule transfer( const schedule & s, const context & target )
+{
+    char * text = isl_schedule_to_str(s.get());
+    if (!text)
+        throw error("Can not print schedule.");
+    isl_schedule * result = isl_schedule_read_from_str(target.get(), text);
+    free(text);
+    return result;
+}
+
+}
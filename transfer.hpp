@@ -0,0 +1,57 @@
+/*
+isl-cpp: C++ bindings to the ISL (Integer Set Library)
+
+Copyright (C) 2014  Jakob Leben <jakob.leben@gmail.com>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef ISL_CPP_TRANSFER_INCLUDED
+#define ISL_CPP_TRANSFER_INCLUDED
+
+#include "context.hpp"
+#include "space.hpp"
+#include "value.hpp"
+#include "set.hpp"
+#include "map.hpp"
+#include "expression.hpp"
+#include "schedule.hpp"
+
+namespace isl {
+
+// Recreate an object in another context.
+//
+// Sets and maps are rebuilt from the constraint matrices of their basic
+// components, so nothing is printed or parsed. Integer divisions are
+// recreated as existentially quantified variables, which preserves the
+// set of points but not necessarily the representation.
+// Identifiers keep their names and user pointers.
+
+value transfer( const value &, const context & target );
+space transfer( const space &, const context & target );
+basic_set transfer( const basic_set &, const context & target );
+set transfer( const set &, const context & target );
+union_set transfer( const union_set &, const context & target );
+basic_map transfer( const basic_map &, const context & target );
+map transfer( const map &, const context & target );
+union_map transfer( const union_map &, const context & target );
+expression transfer( const expression &, const context & target );
+
+// Schedule trees are transferred through their textual form.
+schedule transfer( const schedule &, const context & target );
+
+}
+
+#endif // ISL_CPP_TRANSFER_INCLUDED
@@ -0,0 +1,358 @@
+/*
+isl-cpp: C++ bindings to the ISL (Integer Set Library)
+
+Copyright (C) 2014  Jakob Leben <jakob.leben@gmail.com>
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef ISL_CPP_TYPED_INCLUDED
+#define ISL_CPP_TYPED_INCLUDED
+
+#include "space.hpp"
+#include "set.hpp"
+#include "map.hpp"
+#include "expression.hpp"
+
+#include <utility>
+
+namespace isl {
+
+// Spaces, sets and maps with the number of dimensions in their type.
+//
+// The counts are checked once, when a typed object is made from an
+// untyped one, and throw isl::error on mismatch. After that, dimension
+// counts are constant expressions and variable indices are checked at
+// compile time. Members of set and map that change the number of
+// dimensions in place are deleted. The untyped classes remain for
+// spaces whose shape is only known at run time.
+
+namespace detail {
+
+inline
+void check_dimensions( bool ok )
+{
+    if (!ok)
+        throw error("Unexpected number of dimensions.");
+}
+
+}
+
+template <unsigned Params, unsigned Dims> class typed_set;
+template <unsigned Params, unsigned In, unsigned Out> class typed_map;
+
+template <unsigned Params, unsigned Dims>
+class static_set_space
+{
+public:
+    static constexpr unsigned parameter_count = Params;
+    static constexpr unsigned variable_count = Dims;
+
+    static constexpr unsigned dimension( space::dimension_type type )
+    {
+        return type == space::parameter ? Params :
+               type == space::variable ? Dims : 0;
+    }
+
+    // A set space with unnamed parameters.
+    static_set_space( const context & ctx, const string & name = string() ):
+        m_space(ctx, tuple(Params), tuple(name, Dims))
+    {}
+
+    static_set_space( const context & ctx, const tuple & params, const tuple & vars ):
+        m_space(ctx, params, vars)
+    {
+        detail::check_dimensions(params.size() == Params && vars.size() == Dims);
+    }
+
+    explicit static_set_space( const space & s ):
+        m_space(s)
+    {
+        detail::check_dimensions(s.is_set() &&
+                                 s.dimension(space::parameter) == Params &&
+                                 s.dimension(space::variable) == Dims);
+    }
+
+    template <unsigned I>
+    expression param() const
+    {
+        static_assert(I < Params, "Parameter index out of range.");
+        return m_space.param(I);
+    }
+
+    template <unsigned I>
+    expression var() const
+    {
+        static_assert(I < Dims, "Variable index out of range.");
+        return m_space.var(I);
+    }
+
+    const space & dynamic() const { return m_space; }
+    operator const space & () const { return m_space; }
+
+private:
+    template <unsigned, unsigned> friend class typed_set;
+    template <unsigned, unsigned, unsigned> friend class static_space;
+
+    struct unchecked {};
+    static_set_space( unchecked, space && s ): m_space(std::move(s)) {}
+
+    space m_space;
+};
+
+template <unsigned Params, unsigned Dims>
+constexpr unsigned static_set_space<Params, Dims>::parameter_count;
+template <unsigned Params, unsigned Dims>
+constexpr unsigned static_set_space<Params, Dims>::variable_count;
+
+template <unsigned Params, unsigned In, unsigned Out>
+class static_space
+{
+public:
+    static constexpr unsigned parameter_count = Params;
+    static constexpr unsigned input_count = In;
+    static constexpr unsigned output_count = Out;
+
+    static constexpr unsigned dimension( space::dimension_type type )
+    {
+        return type == space::parameter ? Params :
+               type == space::input ? In :
+               type == space::output ? Out : 0;
+    }
+
+    // A map space with unnamed parameters.
+    static_space( const context & ctx,
+                  const string & in_name = string(),
+                  const string & out_name = string() ):
+        m_space(ctx, tuple(Params), tuple(in_name, In), tuple(out_name, Out))
+    {}
+
+    static_space( const context & ctx, const tuple & params,
+                  const tuple & in, const tuple & out ):
+        m_space(ctx, params, in, out)
+    {
+        detail::check_dimensions(params.size() == Params &&
+                                 in.size() == In && out.size() == Out);
+    }
+
+    explicit static_space( const space & s ):
+        m_space(s)
+    {
+        detail::check_dimensions(s.is_map() &&
+                                 s.dimension(space::parameter) == Params &&
+                                 s.dimension(space::input) == In &&
+                                 s.dimension(space::output) == Out);
+    }
+
+    template <unsigned I>
+    expression param() const
+    {
+        static_assert(I < Params, "Parameter index out of range.");
+        return m_space.param(I);
+    }
+
+    // Expressions on a map space are defined on its wrapped set space,
+    // where the outputs follow the inputs.
+
+    template <unsigned I>
+    expression in() const
+    {
+        static_assert(I < In, "Input index out of range.");
+        return expression::variable(wrapped(), space::variable, I);
+    }
+
+    template <unsigned I>
+    expression out() const
+    {
+        static_assert(I < Out, "Output index out of range.");
+        return expression::variable(wrapped(), space::variable, In + I);
+    }
+
+    static_set_space<Params, In> domain() const
+    {
+        return { typename static_set_space<Params, In>::unchecked(),
+                 space(isl_space_domain(m_space.copy())) };
+    }
+
+    static_set_space<Params, Out> range() const
+    {
+        return { typename static_set_space<Params, Out>::unchecked(),
+                 space(isl_space_range(m_space.copy())) };
+    }
+
+    const space & dynamic() const { return m_space; }
+    operator const space & () const { return m_space; }
+
+private:
+    template <unsigned, unsigned, unsigned> friend class typed_map;
+
+    struct unchecked {};
+    static_space( unchecked, space && s ): m_space(std::move(s)) {}
+
+    local_space wrapped() const
+    {
+        return local_space(space(isl_space_wrap(m_space.copy())));
+    }
+
+    space m_space;
+};
+
+template <unsigned Params, unsigned In, unsigned Out>
+constexpr unsigned static_space<Params, In, Out>::parameter_count;
+template <unsigned Params, unsigned In, unsigned Out>
+constexpr unsigned static_space<Params, In, Out>::input_count;
+template <unsigned Params, unsigned In, unsigned Out>
+constexpr unsigned static_space<Params, In, Out>::output_count;
+
+template <unsigned Params, unsigned Dims>
+class typed_set : public set
+{
+public:
+    typedef static_set_space<Params, Dims> space_type;
+
+    explicit typed_set( const set & s ): set(s) { check(); }
+    explicit typed_set( set && s ): set(std::move(s)) { check(); }
+
+    typed_set( context & ctx, const string & text ): set(ctx, text) { check(); }
+
+    static typed_set universe( const space_type & s )
+    {
+        return typed_set(unchecked(), set::universe(s.dynamic()));
+    }
+
+    static constexpr unsigned dimensions() { return Dims; }
+    static constexpr unsigned parameters() { return Params; }
+
+    space_type get_space() const
+    {
+        return { typename space_type::unchecked(), set::get_space() };
+    }
+
+    template <unsigned I>
+    expression var() const { return get_space().template var<I>(); }
+
+    template <unsigned I>
+    expression param() const { return get_space().template param<I>(); }
+
+    void add_dimensions( space::dimension_type, unsigned = 1 ) = delete;
+    void insert_dimensions( unsigned, unsigned ) = delete;
+    void project_out_dimensions( space::dimension_type, unsigned, unsigned = 1 ) = delete;
+
+private:
+    template <unsigned, unsigned, unsigned> friend class typed_map;
+
+    struct unchecked {};
+    typed_set( unchecked, set && s ): set(std::move(s)) {}
+
+    void check() const
+    {
+        detail::check_dimensions(
+                    isl_set_dim(get(), isl_dim_param) == (isl_size) Params &&
+                    isl_set_dim(get(), isl_dim_set) == (isl_size) Dims);
+    }
+};
+
+template <unsigned Params, unsigned In, unsigned Out>
+class typed_map : public map
+{
+public:
+    typedef static_space<Params, In, Out> space_type;
+
+    explicit typed_map( const map & m ): map(m) { check(); }
+    explicit typed_map( map && m ): map(std::move(m)) { check(); }
+
+    typed_map( context & ctx, const string & text ): map(ctx, text) { check(); }
+
+    static typed_map universe( const space_type & s )
+    {
+        return typed_map(unchecked(), map::universe(s.dynamic()));
+    }
+
+    static constexpr unsigned parameters() { return Params; }
+    static constexpr unsigned inputs() { return In; }
+    static constexpr unsigned outputs() { return Out; }
+
+    space_type get_space() const
+    {
+        return { typename space_type::unchecked(), map::get_space() };
+    }
+
+    template <unsigned I>
+    expression in() const { return get_space().template in<I>(); }
+
+    template <unsigned I>
+    expression out() const { return get_space().template out<I>(); }
+
+    typed_set<Params, In> domain() const &
+    {
+        return { typename typed_set<Params, In>::unchecked(), map::domain() };
+    }
+    typed_set<Params, In> domain() &&
+    {
+        return { typename typed_set<Params, In>::unchecked(),
+                 static_cast<map&&>(*this).domain() };
+    }
+
+    typed_set<Params, Out> range() const &
+    {
+        return { typename typed_set<Params, Out>::unchecked(), map::range() };
+    }
+    typed_set<Params, Out> range() &&
+    {
+        return { typename typed_set<Params, Out>::unchecked(),
+                 static_cast<map&&>(*this).range() };
+    }
+
+    typed_map<Params, Out, In> inverse() const &
+    {
+        return { typename typed_map<Params, Out, In>::unchecked(), map::inverse() };
+    }
+    typed_map<Params, Out, In> inverse() &&
+    {
+        return { typename typed_map<Params, Out, In>::unchecked(),
+                 static_cast<map&&>(*this).inverse() };
+    }
+
+    // Applies this map to a set of matching dimensions.
+    typed_set<Params, Out> operator()( const typed_set<Params, In> & s ) const
+    {
+        return { typename typed_set<Params, Out>::unchecked(),
+                 set(isl_set_apply(s.copy(), copy())) };
+    }
+
+    void add_dimensions( space::dimension_type, unsigned ) = delete;
+    void insert_dimensions( space::dimension_type, unsigned, unsigned ) = delete;
+    void project_out_dimensions( space::dimension_type, unsigned, unsigned = 1 ) = delete;
+    void map_domain_through( const map & ) = delete;
+    void map_range_through( const map & ) = delete;
+
+private:
+    template <unsigned, unsigned, unsigned> friend class typed_map;
+
+    struct unchecked {};
+    typed_map( unchecked, map && m ): map(std::move(m)) {}
+
+    void check() const
+    {
+        detail::check_dimensions(
+                    isl_map_dim(get(), isl_dim_param) == (isl_size) Params &&
+                    isl_map_dim(get(), isl_dim_in) == (isl_size) In &&
+                    isl_map_dim(get(), isl_dim_out) == (isl_size) Out);
+    }
+};
+
+}
+
+#endif // ISL_CPP_TYPED_INCLUDED